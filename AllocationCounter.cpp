@@ -0,0 +1,48 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+#if defined(COUNT_ALLOCATIONS)
+
+// Replaces global operator new, so that we can count allocations. Other forms of new and delete call these.
+
+namespace {
+std::atomic<uint64_t> allocationCount = 0;
+}
+
+uint64_t getAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+    while (true) {
+        if (auto pointer = std::malloc(size))
+            return pointer;
+        auto handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+#else
+
+uint64_t getAllocationCount() {
+    return 0;
+}
+
+#endif
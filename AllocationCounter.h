@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Allocations are counted only when built with COUNT_ALLOCATIONS (CMake option, off by default),
+// because counting replaces global operator new and delete for the whole program.
+
+/// True if getAllocationCount() counts allocations.
+constexpr bool allocationCountingEnabled =
+#if defined(COUNT_ALLOCATIONS)
+    true;
+#else
+    false;
+#endif
+
+/// @returns Number of heap allocations (calls to operator new) since start of the program. Always 0 without COUNT_ALLOCATIONS.
+uint64_t getAllocationCount();
@@ -4,38 +4,130 @@
 #include "Utilities.h"
 
 #include "zerrors.h"
+#include "zstr.h"
 
 #include "nlohmann/json.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
-#include <numeric>
+#include <limits>
+#include <random>
 
 
-std::tuple< raylib::Vector2, raylib::Texture2D&, raylib::Sound* > Animation::spriteForTime(float animationTime) {
+std::tuple< raylib::Vector2, const Sprite&, SoundId > AnimationClip::spriteForTime(float animationTime) const {
     ZASSERT(animationLength > 0.0f);
 
     if (!loop && (animationTime >= animationLength))
-        return std::tuple< raylib::Vector2, raylib::Texture2D&, raylib::Sound* > { origins.back(), *images.back(), nullptr };
+        return std::tuple< raylib::Vector2, const Sprite&, SoundId > { origins.back(), *sprites.back(), noSound };
 
-    while (animationTime >= animationLength)
-        animationTime -= animationLength;
+    auto i = frameForTime(animationTime);
+    return std::tuple< raylib::Vector2, const Sprite&, SoundId > { origins[i], *sprites[i], sounds[i] };
+}
+
+int AnimationClip::frameForTime(float animationTime) const {
+    ZASSERT(animationLength > 0.0f);
+
+    auto lastFrame = static_cast<int>(std::ssize(frameEnds)) - 1;
+    if (animationTime < 0.0f)
+        return 0;
+    if (animationTime >= animationLength) {
+        if (!loop)
+            return lastFrame;
+        animationTime = std::fmod(animationTime, animationLength);
+    }
+
+    if (uniformDelay > 0.0f)
+        return std::min(static_cast<int>(animationTime / uniformDelay), lastFrame);
+
+    auto it = std::upper_bound(frameEnds.begin(), frameEnds.end(), animationTime);
+    return std::min(static_cast<int>(it - frameEnds.begin()), lastFrame);
+}
+
+void AnimationClip::compile() {
+    frameEnds.clear();
     float time = 0.0f;
-    int i = 0;
-    for (; i < std::ssize(images); ++i) {
-        time += delays[i];
-        if (animationTime < time)
-            break;
+    for (auto delay : delays) {
+        time += delay;
+        frameEnds.push_back(time);
+    }
+    animationLength = time;
+
+    bounds = raylib::Rectangle{ 0.0f, 0.0f, 0.0f, 0.0f };
+    bool hasBounds = false;
+    for (int i = 0; i < std::ssize(sprites); ++i) {
+        if (sprites[i]->source.width <= 0.0f)
+            continue;
+        raylib::Rectangle frameBounds{ -origins[i], sprites[i]->GetSize() };
+        if (!hasBounds) {
+            bounds = frameBounds;
+            hasBounds = true;
+            continue;
+        }
+        auto right = std::max(bounds.x + bounds.width, frameBounds.x + frameBounds.width);
+        auto bottom = std::max(bounds.y + bounds.height, frameBounds.y + frameBounds.height);
+        bounds.x = std::min(bounds.x, frameBounds.x);
+        bounds.y = std::min(bounds.y, frameBounds.y);
+        bounds.width = right - bounds.x;
+        bounds.height = bottom - bounds.y;
+    }
+
+    uniformDelay = delays.empty() ? 0.0f : delays.front();
+    if (std::any_of(delays.begin(), delays.end(), [&](float delay) { return delay != uniformDelay; }))
+        uniformDelay = 0.0f;
+}
+
+void AnimationClip::benchmark(int iterations) const {
+    // Lookup as it was done before lookup tables.
+    auto scanFrameForTime = [&](float animationTime) {
+        if (!loop && (animationTime >= animationLength))
+            return static_cast<int>(std::ssize(delays)) - 1;
+        while (animationTime >= animationLength)
+            animationTime -= animationLength;
+        float time = 0.0f;
+        int i = 0;
+        for (; i < std::ssize(delays) - 1; ++i) {
+            time += delays[i];
+            if (animationTime < time)
+                break;
+        }
+        return i;
+    };
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> timeDistribution(0.0f, 10.0f * animationLength);
+    std::vector<float> times(iterations);
+    for (auto& time : times)
+        time = timeDistribution(rng);
+
+    int checksum = 0;
+    auto startTime = GetTime();
+    for (auto time : times)
+        checksum += scanFrameForTime(time);
+    auto scanTime = GetTime() - startTime;
+
+    startTime = GetTime();
+    for (auto time : times)
+        checksum -= frameForTime(time);
+    auto tableTime = GetTime() - startTime;
+
+    // Wrapping with fmod is more precise than repeated subtraction, so frames can differ right at frame boundaries.
+    int mismatches = 0;
+    for (auto time : times) {
+        if (scanFrameForTime(time) != frameForTime(time))
+            ++mismatches;
     }
 
-    return std::tuple< raylib::Vector2, raylib::Texture2D&, raylib::Sound* > { origins[i], *images[i], sounds[i] };
+    TraceLog(LOG_INFO, (ZSTR() << "Animation lookup (" << std::ssize(delays) << " frames, " << (uniformDelay > 0.0f ? "uniform" : "variable") << "): scan " << scanTime * 1000.0 << " ms, table " << tableTime * 1000.0 << " ms, " << mismatches << " mismatches out of " << iterations << " (checksum " << checksum << ")").str().c_str());
 }
 
 
-void Animation::load(ResourceCache& resourceCache, const std::string& animFile) {
-    images.clear();
+void AnimationClip::load(ResourceCache& resourceCache, SoundService& soundService, const std::string& animFile, int loadGroup) {
+    sprites.clear();
     origins.clear();
     sounds.clear();
     delays.clear();
+    resources.clear();
 
     auto jsonText = loadTextFile(animFile);
 
@@ -54,31 +146,97 @@ void Animation::load(ResourceCache& resourceCache, const std::string& animFile)
             soundPath = frame["sound"].get<std::string>();
         }
 
-        if (soundPath.empty())
-            sounds.push_back(nullptr);
-        else
-            sounds.emplace_back(resourceCache.getSound((basePath / soundPath).string()));
+        if (soundPath.empty()) {
+            sounds.push_back(noSound);
+        }
+        else {
+            sounds.push_back(soundService.load(resourceCache.getPath(resourceCache.internPath(basePath, soundPath))));
+        }
 
-        if (imagePath.empty())
-            images.push_back(resourceCache.getEmptyImage());
-        else
-            images.push_back(resourceCache.getImage((basePath / imagePath).string()));
+        if (imagePath.empty()) {
+            sprites.push_back(&resourceCache.getEmptySprite());
+        }
+        else {
+            resources.emplace_back();
+            sprites.push_back(&resourceCache.getSprite(resourceCache.internPath(basePath, imagePath), resources.back(), loadGroup));
+        }
         origins.emplace_back(originX, originY);
         delays.push_back(delay);
     }
 
-    animationLength = std::accumulate(delays.begin(), delays.end(), 0.0f);
+    compile();
 }
 
-void Animation::fromPicture(ResourceCache& resourceCache, const std::string& imageFile, float length) {
-    images.clear();
+void AnimationClip::fromPicture(ResourceCache& resourceCache, const std::string& imageFile, float length, int loadGroup) {
+    sprites.clear();
     origins.clear();
     sounds.clear();
     delays.clear();
+    resources.clear();
 
-    images.push_back(resourceCache.getImage(imageFile));
-    sounds.push_back(nullptr);
+    resources.emplace_back();
+    sprites.push_back(&resourceCache.getImageSprite(resourceCache.internPath(imageFile), resources.back(), loadGroup));
+    sounds.push_back(noSound);
     origins.emplace_back(0.0f, 0.0f);
     delays.push_back(length);
-    animationLength = length;
+    compile();
+}
+
+
+void AnimationClip::getResources(std::vector<const ResourceEntry*>& entries) const {
+    for (const auto& resource : resources) {
+        if (resource)
+            entries.push_back(resource.getEntry());
+    }
+}
+
+
+bool AnimationPlayer::play(const AnimationClip& newClip, bool restart) {
+    if ((clip == &newClip) && !restart)
+        return false;
+
+    clip = &newClip;
+    if (restart)
+        time = 0.0f;
+    frame = -1;
+    return updateFrame();
+}
+
+bool AnimationPlayer::seek(float newTime) {
+    time = newTime;
+    if (!clip)
+        return false;
+    return updateFrame();
+}
+
+bool AnimationPlayer::updateFrame() {
+    // Most of the time we are still in the same frame.
+    if ((frame >= 0) && (time >= frameStart) && (time < frameEnd))
+        return false;
+
+    auto newFrame = clip->frameForTime(time);
+
+    auto length = clip->getAnimationLength();
+    if (time < 0.0f) {
+        frameStart = -std::numeric_limits<float>::infinity();
+        frameEnd = clip->getFrameEnd(newFrame);
+    }
+    else
+    if (time >= length && !clip->loop) {
+        frameStart = length;
+        frameEnd = std::numeric_limits<float>::infinity();
+    }
+    else {
+        auto loopStart = time - std::fmod(time, length);
+        frameStart = loopStart + clip->getFrameStart(newFrame);
+        frameEnd = loopStart + clip->getFrameEnd(newFrame);
+    }
+
+    if (newFrame == frame)
+        return false;
+
+    frame = newFrame;
+    if (playSounds && (clip->getSound(frame) != noSound))
+        sound = clip->getSound(frame);
+    return true;
 }
@@ -1,30 +1,99 @@
 #pragma once
 
 #include "ResourceCache.h"
+#include "SoundService.h"
 
 #include "raylib-cpp.hpp"
 
 #include <tuple>
+#include <utility>
 #include <vector>
 
 
-class Animation {
+/// Frames of an animation. Doesn't change after loading, so it can be shared by any number of AnimationPlayers.
+class AnimationClip {
 private:
-    std::vector<raylib::Texture2D*> images; ///< Empty image to show empty image.
-    std::vector<raylib::Sound*> sounds;     ///< Nullptr for no sound.
+    std::vector<const Sprite*> sprites;     ///< Owned by ResourceCache. Empty sprite to show empty image.
+    std::vector<SoundId> sounds;            ///< Loaded through SoundService, noSound for no sound.
+    std::vector<ResourceHandle> resources;  ///< Keep sprites loaded.
     std::vector<raylib::Vector2> origins;
     std::vector<float> delays;      ///< How long to display given frame (in seconds).
+    std::vector<float> frameEnds;   ///< Time when given frame ends (prefix sums of delays).
+    float uniformDelay = 0.0f;      ///< Delay of every frame if they are all the same, zero otherwise.
     float animationLength = 0.0f;   ///< How long is the animation (in seconds).
+    raylib::Rectangle bounds = { 0.0f, 0.0f, 0.0f, 0.0f };   ///< Bounds of all frames, relative to the drawing position (not mirrored).
 
 public:
     bool loop = true;               ///< True to loop.
 
 public:
-    std::tuple< raylib::Vector2, raylib::Texture2D&, raylib::Sound* > spriteForTime(float animationTime);
+    std::tuple< raylib::Vector2, const Sprite&, SoundId > spriteForTime(float animationTime) const;
+
+    /// @returns Index of the frame shown at given time. Past the end of non-looped animation returns the last frame.
+    int frameForTime(float animationTime) const;
 
     float getAnimationLength() const { return animationLength; }
 
-    void load(ResourceCache& resourceCache, const std::string& animFile);
-    void fromPicture(ResourceCache& resourceCache, const std::string& imageFile, float length = 1.0f);
+    /// @returns Bounds of all frames drawn at given position (not mirrored).
+    raylib::Rectangle getBounds(raylib::Vector2 position) const { return { position + bounds.GetPosition(), bounds.GetSize() }; }
+    int getFrameCount() const { return static_cast<int>(std::ssize(sprites)); }
+    raylib::Vector2 getOrigin(int frame) const { return origins[frame]; }
+    const Sprite& getSprite(int frame) const { return *sprites[frame]; }
+    SoundId getSound(int frame) const { return sounds[frame]; }
+    float getFrameStart(int frame) const { return frameEnds[frame] - delays[frame]; }
+    float getFrameEnd(int frame) const { return frameEnds[frame]; }
+
+    /// @param loadGroup    ResourceCache load group, to load frames asynchronously.
+    /// @note Bounds only include frames that were loaded when the clip was, so don't cull clips loaded asynchronously.
+    /// @note Sounds are loaded right away, SoundService keeps them for the whole game.
+    void load(ResourceCache& resourceCache, SoundService& soundService, const std::string& animFile, int loadGroup = ResourceCache::loadNow);
+    void fromPicture(ResourceCache& resourceCache, const std::string& imageFile, float length = 1.0f, int loadGroup = ResourceCache::loadNow);
+
+    /// Appends cache entries of sprites of the clip.
+    void getResources(std::vector<const ResourceEntry*>& entries) const;
+
+    /// Checks frameForTime() against a linear scan over delays, and logs how long both took.
+    void benchmark(int iterations) const;
+
+private:
+    /// Builds lookup tables from delays.
+    void compile();
+};
+
+/// Plays an AnimationClip for a single entity. Tracks the current frame, so it knows when a new frame is entered.
+class AnimationPlayer {
+private:
+    const AnimationClip* clip = nullptr;
+    float time = 0.0f;          ///< Time since start of the clip (in seconds).
+    int frame = -1;             ///< Current frame, or -1 if not known yet.
+    float frameStart = 0.0f;    ///< When current frame started, in the same time as time.
+    float frameEnd = 0.0f;      ///< When current frame ends, in the same time as time.
+    SoundId sound = noSound;    ///< Sound of the last entered frame, until taken.
+
+public:
+    bool playSounds = true;     ///< True to report sound of every entered frame through takeSound().
+
+public:
+    /// Switches to given clip. Time is kept, unless restart is true.
+    /// @returns True if a new frame was entered.
+    bool play(const AnimationClip& newClip, bool restart = false);
+
+    /// @returns True if a new frame was entered.
+    bool advance(float timeDelta) { return seek(time + timeDelta); }
+
+    /// @returns True if a new frame was entered.
+    bool seek(float newTime);
+
+    const AnimationClip* getClip() const { return clip; }
+    float getTime() const { return time; }
+    int getFrame() const { return frame; }
+    raylib::Vector2 getOrigin() const { return clip->getOrigin(frame); }
+    const Sprite& getSprite() const { return clip->getSprite(frame); }
+
+    /// @returns Sound of the last frame entered since the previous call, or noSound. Play it through SoundService.
+    SoundId takeSound() { return std::exchange(sound, noSound); }
+
+private:
+    bool updateFrame();
 };
 
@@ -0,0 +1,62 @@
+#include "BakedFont.h"
+
+#include "FileSystem.h"
+#include "Utilities.h"
+
+#include "zstr.h"
+#include "zerrors.h"
+
+#include "nlohmann/json.hpp"
+
+#include <filesystem>
+
+
+std::string bakedFontName(const std::string& fontFile, int fontSize, bool sdf) {
+    auto path = std::filesystem::path(fontFile);
+    auto name = (ZSTR() << path.stem().string() << "-" << fontSize << (sdf ? "-sdf" : "")).str();
+    return (path.parent_path() / name).generic_string();
+}
+
+raylib::Font loadBakedFont(const std::string& bakedName) {
+    auto json = nlohmann::json::parse(loadTextFile(bakedName + ".json"));
+    const auto& glyphs = json["glyphs"];
+
+    // raylib frees these with UnloadFont(), so they must come from its allocator.
+    ::Font font = {};
+    font.baseSize = json["size"].get<int>();
+    font.glyphPadding = json["padding"].get<int>();
+    font.glyphCount = static_cast<int>(std::ssize(glyphs));
+    font.recs = static_cast<::Rectangle*>(MemAlloc(font.glyphCount * sizeof(::Rectangle)));
+    font.glyphs = static_cast<::GlyphInfo*>(MemAlloc(font.glyphCount * sizeof(::GlyphInfo)));
+
+    // Every glyph is [codepoint, x, y, width, height, offsetX, offsetY, advanceX].
+    for (int i = 0; i < font.glyphCount; ++i) {
+        const auto& glyph = glyphs[i];
+        ZASSERT(glyph.size() == 8) << "Invalid glyph " << i << " in baked font '" << bakedName << "'.";
+        font.glyphs[i] = ::GlyphInfo{ glyph[0].get<int>(), glyph[5].get<int>(), glyph[6].get<int>(), glyph[7].get<int>(), ::Image{} };
+        font.recs[i] = ::Rectangle{ glyph[1].get<float>(), glyph[2].get<float>(), glyph[3].get<float>(), glyph[4].get<float>() };
+    }
+
+    auto atlas = loadImageFile(bakedName + ".png");
+    font.texture = LoadTextureFromImage(atlas);
+    if (json.value("sdf", false))
+        SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR); // Distance field is meant to be interpolated.
+
+    return raylib::Font(font);
+}
+
+raylib::Font loadFont(const std::string& fontFile, int fontSize, const std::string& charsetFile) {
+    auto loadStartTime = GetTime();
+    auto bakedName = bakedFontName(fontFile, fontSize, false);
+    // Baked font is stale when either the font or the charset was edited since it was baked.
+    if (derivedFileExists(bakedName + ".json", fontFile) && derivedFileExists(bakedName + ".json", charsetFile)) {
+        auto font = loadBakedFont(bakedName);
+        TraceLog(LOG_INFO, (ZSTR() << "Font '" << bakedName << "' loaded in " << (GetTime() - loadStartTime) * 1000.0 << " ms").str().c_str());
+        return font;
+    }
+
+    auto charset = loadCharset(charsetFile);
+    raylib::Font font(fontFile, fontSize, charset.data(), static_cast<int>(std::ssize(charset)));
+    TraceLog(LOG_WARNING, (ZSTR() << "Font '" << fontFile << "' is not baked at " << fontSize << " px, rasterizing it took " << (GetTime() - loadStartTime) * 1000.0 << " ms. Run FontBaker to start faster.").str().c_str());
+    return font;
+}
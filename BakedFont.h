@@ -0,0 +1,20 @@
+#pragma once
+
+#include "raylib-cpp.hpp"
+
+#include <string>
+
+
+// Fonts baked by Tools/FontBaker.cpp are stored next to the font, as <font name>-<size>[-sdf].png with the glyph atlas,
+// and <font name>-<size>[-sdf].json with glyph metrics.
+
+/// @returns Path of baked font files, without extension.
+std::string bakedFontName(const std::string& fontFile, int fontSize, bool sdf);
+
+/// Loads baked font. Throws if it doesn't exist.
+/// @note Glyph images aren't baked, so the font can't be used with ImageDrawText().
+raylib::Font loadBakedFont(const std::string& bakedName);
+
+/// Loads font baked at given size, or rasterizes it from the font file if it wasn't baked (or was baked before the font or the charset changed).
+/// @param charsetFile  Codepoints to rasterize. Only read when the font isn't baked.
+raylib::Font loadFont(const std::string& fontFile, int fontSize, const std::string& charsetFile);
@@ -1,4 +1,3 @@
-
 #include "Collectible.h"
 
 #include "Game.h"
@@ -13,9 +12,9 @@
 
 CollectiblePrefab::CollectiblePrefab(Game& game)
     : game(game)
-    , collectSfx("Sounds/coin.wav")
+    , collectSfx(game.soundService.load("Sounds/coin.wav", SoundSettings{ .maxVoices = 4, .priority = 1, .maxDistance = 1000.0f })) // Pickups in quick succession overlap.
 {
-    wiggleAnimation.load(game.resourceCache, "Graphics/Collectible/collectible-wiggle.json");
+    wiggleAnimation.load(game.resourceCache, game.soundService, "Graphics/Collectible/collectible-wiggle.json");
     load();
 }
 
@@ -24,34 +23,67 @@ void CollectiblePrefab::load() {
     auto jsonText = loadTextFile(playerFile);
     auto json = nlohmann::json::parse(jsonText);
     hitbox = raylib::Rectangle{ json["hitbox"]["x"].get<float>(), json["hitbox"]["y"].get<float>(), json["hitbox"]["width"].get<float>(), json["hitbox"]["height"].get<float>() };
-}
+    phaseSpread = json.value("phaseSpread", 0.0f);
 
-void Collectible::update() {
-    if (collected) {
-        return;
+    auto [origin, image, sound] = wiggleAnimation.spriteForTime(0.0f); // All frames have the same origin.
+    hitboxOffset = hitbox.GetPosition() - origin;
+
+    animTime = 0.0f;
+    for (auto& phase : phases) {
+        phase = AnimationPlayer();
+        phase.playSounds = (&phase == &phases[0]); // Sound is played once for all instances.
+        phase.play(wiggleAnimation);
     }
+    update(0.0f);
+}
 
-    animTime += collectiblePrefab.game.levelTimeDelta;
+void CollectiblePrefab::update(float timeDelta) {
+    animTime += timeDelta;
 
-    auto [origin, image, sound] = collectiblePrefab.wiggleAnimation.spriteForTime(animTime);
+    auto usedPhases = (phaseSpread > 0.0f) ? phaseCount : 1;
+    for (int phase = 0; phase < usedPhases; ++phase)
+        phases[phase].seek(animTime + phase * phaseSpread / phaseCount);
 
-    raylib::Rectangle collectibleRect { position - origin + collectiblePrefab.hitbox.GetPosition(), collectiblePrefab.hitbox.GetSize() };
+    if (auto sound = phases[0].takeSound(); sound != noSound)
+        game.soundService.play(sound);
+}
+
+bool CollectiblePrefab::tryCollect(Collectible& collectible, raylib::Vector2 playerPosition) {
+    if (collectible.collected) {
+        return false;
+    }
 
-    //auto hitBoxPosition = collectiblePrefab.game.worldToScreen(collectibleRect.GetPosition());
-    //DrawRectangleLines(hitBoxPosition.x, hitBoxPosition.y, collectibleRect.GetWidth(), collectibleRect.GetHeight(), GREEN);
+    //auto hitBoxPosition = game.worldToScreen(hitboxAt(collectible.position).GetPosition());
+    //DrawRectangleLines(hitBoxPosition.x, hitBoxPosition.y, hitbox.GetWidth(), hitbox.GetHeight(), GREEN);
 
-    //auto [playerOrigin, playerImage, playerSound] = collectiblePrefab.game.player.runAnimation.spriteForTime(0.0f);
-    //raylib::Rectangle playerRect { collectiblePrefab.game.player.position - playerOrigin + collectiblePrefab.game.player.hitbox.GetPosition(), collectiblePrefab.game.player.hitbox.GetSize() };
-    if (!forHud && collectibleRect.CheckCollision(collectiblePrefab.game.player.position)) {
-        collected = true;
-        collectiblePrefab.collectSfx.Play();
+    if (!hitboxAt(collectible.position).CheckCollision(playerPosition)) {
+        return false;
+    }
+
+    collectible.collected = true;
+    game.soundService.play(collectSfx, collectible.position);
+    return true;
+}
+
+void CollectiblePrefab::draw(const Collectible& collectible) const {
+    if (collectible.collected) {
         return;
     }
 
-    if (sound)
-        sound->Play();
-    if (forHud)
-        image.Draw(position - origin);
-    else
-        collectiblePrefab.game.drawSprite(position, image, origin, false);
+    const auto& phase = phases[phaseOf(collectible.position)];
+    game.drawSprite(collectible.position, phase.getSprite(), phase.getOrigin(), false, SpriteLayer::COLLECTIBLES);
+}
+
+void CollectiblePrefab::drawOnHud(raylib::Vector2 screenPosition) const {
+    const auto& phase = phases[0];
+    game.drawSpriteOnScreen(screenPosition - phase.getOrigin(), phase.getSprite());
+}
+
+int CollectiblePrefab::phaseOf(raylib::Vector2 position) const {
+    if (phaseSpread <= 0.0f)
+        return 0;
+
+    // Neighbouring collectibles get consecutive phases, so rows of them animate in a wave.
+    auto cell = static_cast<int>(std::floor(position.x / 16.0f)) + static_cast<int>(std::floor(position.y / 16.0f));
+    return ((cell % phaseCount) + phaseCount) % phaseCount;
 }
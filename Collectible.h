@@ -1,45 +1,65 @@
 #pragma once
 
 #include "Animation.h"
+#include "SoundService.h"
 
 
 #include "raylib-cpp.hpp"
 #include "zerrors.h"
 
+#include <array>
+
 
 class Game;
 
 
+/// Collectible instance. Animation state lives in CollectiblePrefab and is shared by all instances.
+struct Collectible {
+    raylib::Vector2 position = { 0.0f, 0.0f };
+    bool collected = false;     ///< True if it was already collected.
+};
+
 class CollectiblePrefab {
 public:
     Game& game;
 
+    static constexpr int phaseCount = 4;    ///< Number of animation phases instances are spread over.
+
 public:
     raylib::Rectangle hitbox;
-    Animation wiggleAnimation;
-    raylib::Sound collectSfx;
+    raylib::Vector2 hitboxOffset;   ///< Offset of the hitbox from collectible position (includes animation origin).
+    AnimationClip wiggleAnimation;
+    SoundId collectSfx;
+    float phaseSpread = 0.0f;       ///< Instances are offset in time by up to this much (in seconds). Zero to animate all in sync.
+
+private:
+    float animTime = 0.0f;                          ///< Clock shared by all instances.
+    std::array<AnimationPlayer, phaseCount> phases; ///< Current frame for every phase.
 
 public:
     CollectiblePrefab(Game& game);
 
     void load();
-};
 
-class Collectible {
-private:
-    CollectiblePrefab& collectiblePrefab;
+    /// Advances the shared clock and looks up current frames. Call once per frame, before drawing instances.
+    void update(float timeDelta);
 
-public:
-    raylib::Vector2 position = { 0.0f, 0.0f };
-    float animTime = 0.0f;      ///< Time for current animation.
-    bool collected = false;     ///< True if it was already collected.
-    bool forHud = false;        ///< If True collisions don't count, position is screen pos (as opposed to world pos). Doesn't count towards level collectibles.
+    /// Collects if player position is inside the hitbox.
+    /// @returns True if it was collected now.
+    bool tryCollect(Collectible& collectible, raylib::Vector2 playerPosition);
 
-public:
-    Collectible(CollectiblePrefab& collectiblePrefab)
-        : collectiblePrefab(collectiblePrefab)
-    {
-    }
+    /// Draws collectible in the world, unless it was collected.
+    void draw(const Collectible& collectible) const;
 
-    void update();
+    /// Draws collectible icon at given screen position.
+    void drawOnHud(raylib::Vector2 screenPosition) const;
+
+    /// @returns Bounds of the sprite of a collectible at given position, in world coordinates.
+    raylib::Rectangle drawBoundsAt(raylib::Vector2 position) const { return wiggleAnimation.getBounds(position); }
+
+    /// @returns Hitbox of a collectible at given position, in world coordinates.
+    raylib::Rectangle hitboxAt(raylib::Vector2 position) const { return { position + hitboxOffset, hitbox.GetSize() }; }
+
+private:
+    int phaseOf(raylib::Vector2 position) const;
 };
@@ -0,0 +1,71 @@
+#include "DynamicCollider.h"
+
+#include "Utilities.h"
+
+#include "zerrors.h"
+
+#include <cmath>
+
+
+void DynamicCollider::load(const nlohmann::json& entity, int tileSize) {
+    auto startRect = loadJsonRect(entity);
+    const auto& customFields = entity["customFields"];
+
+    std::vector<raylib::Vector2> points { startRect.GetPosition() };
+    for (const auto& point : customFields["path"]) {
+        points.emplace_back(point["cx"].get<float>() * tileSize, point["cy"].get<float>() * tileSize);
+    }
+
+    auto pingPong = true;
+    if (customFields.contains("pingPong")) {
+        pingPong = customFields["pingPong"].get<bool>();
+    }
+
+    setPath(startRect, std::move(points), customFields["speed"].get<float>(), pingPong);
+}
+
+void DynamicCollider::setPath(raylib::Rectangle startRect, std::vector<raylib::Vector2> path, float speed, bool pingPong) {
+    ZASSERT(!path.empty());
+    rect = startRect;
+    velocity = raylib::Vector2::Zero();
+    this->path = std::move(path);
+    this->speed = speed;
+    this->pingPong = pingPong;
+    pathTime = 0.0f;
+
+    pathLength = 0.0f;
+    for (int i = 1; i < std::ssize(this->path); ++i)
+        pathLength += this->path[i].Distance(this->path[i - 1]);
+    pathLength *= pingPong ? 2.0f : 1.0f;
+    if (!pingPong)
+        pathLength += this->path.back().Distance(this->path.front());
+}
+
+raylib::Vector2 DynamicCollider::positionAt(float distance) const {
+    auto numPoints = static_cast<int>(std::ssize(path));
+    auto numSegments = pingPong ? 2 * (numPoints - 1) : numPoints;
+    for (int segment = 0; segment < numSegments; ++segment) {
+        // Ping-pong goes 0, 1, ..., n-1, n-2, ..., 0.
+        auto from = (pingPong && (segment >= numPoints - 1)) ? 2 * (numPoints - 1) - segment : segment;
+        auto to = pingPong ? ((segment >= numPoints - 1) ? from - 1 : from + 1) : (segment + 1) % numPoints;
+        auto segmentLength = path[from].Distance(path[to]);
+        if ((distance < segmentLength) || (segment == numSegments - 1)) {
+            auto fraction = (segmentLength > 0.0f) ? std::min(distance / segmentLength, 1.0f) : 0.0f;
+            return path[from] + (path[to] - path[from]) * fraction;
+        }
+        distance -= segmentLength;
+    }
+    return path.front();
+}
+
+void DynamicCollider::update(float timeDelta) {
+    if ((timeDelta <= 0.0f) || (pathLength <= 0.0f) || (speed <= 0.0f)) {
+        velocity = raylib::Vector2::Zero();
+        return;
+    }
+
+    pathTime += timeDelta;
+    auto newPosition = positionAt(std::fmod(pathTime * speed, pathLength));
+    velocity = (newPosition - rect.GetPosition()) / timeDelta;
+    rect.SetPosition(newPosition);
+}
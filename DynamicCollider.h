@@ -0,0 +1,33 @@
+#pragma once
+
+#include "raylib-cpp.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <vector>
+
+
+/// Solid rectangle moving along a scripted path (moving platforms, doors, etc.).
+class DynamicCollider {
+public:
+    raylib::Rectangle rect = { 0.0f, 0.0f, 0.0f, 0.0f };    ///< Current position and size, in world coordinates.
+    raylib::Vector2 velocity = { 0.0f, 0.0f };              ///< Velocity during last update (pixels per second).
+
+    std::vector<raylib::Vector2> path;  ///< Positions of top-left corner of rect. First one is the start position.
+    float speed = 0.0f;                 ///< Speed along the path (pixels per second).
+    bool pingPong = true;               ///< True to go back and forth along the path, false to loop back to the first point.
+    float pathTime = 0.0f;              ///< Time since start of the level.
+
+private:
+    float pathLength = 0.0f;            ///< Length of one full cycle (pixels).
+
+public:
+    /// Loads LDtk entity. Its "path" custom field is a list of points (in tiles), "speed" is in pixels per second.
+    void load(const nlohmann::json& entity, int tileSize);
+    void setPath(raylib::Rectangle startRect, std::vector<raylib::Vector2> path, float speed, bool pingPong);
+
+    void update(float timeDelta);
+
+private:
+    raylib::Vector2 positionAt(float distance) const;
+};
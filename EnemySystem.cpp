@@ -0,0 +1,208 @@
+#include "EnemySystem.h"
+
+#include "Game.h"
+#include "Level.h"
+#include "Utilities.h"
+
+#include "zerrors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+
+namespace {
+
+const float gravity = 900.0f;               ///< Pixels per second squared.
+const float patrolSpeed = 60.0f;            ///< Pixels per second.
+const float jumperJumpVelocity = 420.0f;    ///< Pixels per second.
+const float jumperJumpInterval = 1.5f;      ///< Seconds between jumps.
+const float flyerSpeed = 80.0f;             ///< Pixels per second.
+const float flyerAmplitude = 24.0f;         ///< Height of the wave (pixels).
+const float flyerFrequency = 2.0f;          ///< Radians per second.
+
+} // namespace
+
+
+void EnemyArrays::clear() {
+    x.clear();
+    y.clear();
+    velocityX.clear();
+    velocityY.clear();
+    timer.clear();
+    baseY.clear();
+}
+
+void EnemyArrays::add(raylib::Vector2 position, float velocityX, float timer) {
+    x.push_back(position.x);
+    y.push_back(position.y);
+    this->velocityX.push_back(velocityX);
+    velocityY.push_back(0.0f);
+    this->timer.push_back(timer);
+    baseY.push_back(position.y);
+}
+
+
+void EnemySystem::clear() {
+    patrols.clear();
+    jumpers.clear();
+    flyers.clear();
+    playerHit = false;
+}
+
+void EnemySystem::spawn(EnemyType type, raylib::Vector2 position) {
+    switch (type) {
+        case EnemyType::PATROL: patrols.add(position, patrolSpeed, 0.0f); break;
+        case EnemyType::JUMPER: jumpers.add(position, 0.0f, jumperJumpInterval); break;
+        case EnemyType::FLYER: flyers.add(position, flyerSpeed, 0.0f); break;
+    }
+}
+
+void EnemySystem::spawnRandom(EnemyType type, int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> columnDistribution(0, level.levelWidth / level.tileSize - 1);
+    std::uniform_int_distribution<int> rowDistribution(0, level.levelHeight / level.tileSize - 1);
+
+    auto tileSize = static_cast<float>(level.tileSize);
+    for (int spawned = 0, tries = 0; (spawned < count) && (tries < 100 * count); ++tries) {
+        raylib::Vector2 position { columnDistribution(rng) * tileSize, rowDistribution(rng) * tileSize };
+        if (isSolid(position.x, position.y) || isSolid(position.x + enemySize, position.y + enemySize))
+            continue;
+        if (position.Distance(level.playerStartPosition) < 200.0f)
+            continue;
+        spawn(type, position);
+        ++spawned;
+    }
+}
+
+void EnemySystem::loadFromLdtk(const nlohmann::json& entities) {
+    const std::pair<const char*, EnemyType> entityTypes[] = {
+        { "EnemyPatrol", EnemyType::PATROL },
+        { "EnemyJumper", EnemyType::JUMPER },
+        { "EnemyFlyer", EnemyType::FLYER },
+    };
+
+    for (const auto& [entityName, type] : entityTypes) {
+        if (!entities.contains(entityName))
+            continue;
+        for (const auto& entity : entities[entityName]) {
+            spawn(type, loadJsonRect(entity).GetPosition());
+        }
+    }
+}
+
+bool EnemySystem::isSolid(float worldX, float worldY) const {
+    return isCollider(level.getTileWorld({ worldX, worldY }).value_or(TileType::WALL));
+}
+
+void EnemySystem::update(float timeDelta, raylib::Rectangle playerHitbox) {
+    auto startTime = GetTime();
+
+    playerHit = false;
+    if (timeDelta > 0.0f) {
+        runPass(patrols, playerHitbox, [&](int begin, int end) { updatePatrols(begin, end, timeDelta); });
+        runPass(jumpers, playerHitbox, [&](int begin, int end) { updateJumpers(begin, end, timeDelta); });
+        runPass(flyers, playerHitbox, [&](int begin, int end) { updateFlyers(begin, end, timeDelta); });
+    }
+
+    updateTime = static_cast<float>(GetTime() - startTime);
+}
+
+template<typename UpdateFunc>
+void EnemySystem::runPass(EnemyArrays& enemies, raylib::Rectangle playerHitbox, UpdateFunc updateFunc) {
+    auto count = enemies.size();
+    chunkHits.assign((count + chunkSize - 1) / chunkSize, 0);
+
+    game.jobSystem.parallelFor(count, chunkSize, [&](int begin, int end) {
+        updateFunc(begin, end);
+        for (int i = begin; i < end; ++i) {
+            if (CheckCollisionRecs(playerHitbox, Rectangle{ enemies.x[i], enemies.y[i], enemySize, enemySize })) {
+                chunkHits[begin / chunkSize] = 1;
+                break;
+            }
+        }
+    });
+
+    if (std::find(chunkHits.begin(), chunkHits.end(), 1) != chunkHits.end())
+        playerHit = true;
+}
+
+void EnemySystem::updatePatrols(int begin, int end, float timeDelta) {
+    auto& e = patrols;
+    for (int i = begin; i < end; ++i) {
+        e.velocityY[i] += gravity * timeDelta;
+        auto newY = e.y[i] + e.velocityY[i] * timeDelta;
+        auto grounded = false;
+        if (isSolid(e.x[i] + 1.0f, newY + enemySize) || isSolid(e.x[i] + enemySize - 1.0f, newY + enemySize)) {
+            newY = std::floor((newY + enemySize) / level.tileSize) * level.tileSize - enemySize;
+            e.velocityY[i] = 0.0f;
+            grounded = true;
+        }
+        e.y[i] = newY;
+
+        auto newX = e.x[i] + e.velocityX[i] * timeDelta;
+        auto aheadX = (e.velocityX[i] > 0.0f) ? newX + enemySize : newX;
+        auto wallAhead = isSolid(aheadX, e.y[i] + 1.0f) || isSolid(aheadX, e.y[i] + enemySize - 1.0f);
+        auto ledgeAhead = grounded && !isSolid(aheadX, e.y[i] + enemySize + 1.0f);
+        if (wallAhead || ledgeAhead)
+            e.velocityX[i] = -e.velocityX[i];
+        else
+            e.x[i] = newX;
+    }
+}
+
+void EnemySystem::updateJumpers(int begin, int end, float timeDelta) {
+    auto& e = jumpers;
+    for (int i = begin; i < end; ++i) {
+        e.timer[i] -= timeDelta;
+        e.velocityY[i] += gravity * timeDelta;
+        auto newY = e.y[i] + e.velocityY[i] * timeDelta;
+
+        if ((e.velocityY[i] < 0.0f) && (isSolid(e.x[i] + 1.0f, newY) || isSolid(e.x[i] + enemySize - 1.0f, newY))) {
+            newY = e.y[i];
+            e.velocityY[i] = 0.0f;
+        }
+        if ((e.velocityY[i] >= 0.0f) && (isSolid(e.x[i] + 1.0f, newY + enemySize) || isSolid(e.x[i] + enemySize - 1.0f, newY + enemySize))) {
+            newY = std::floor((newY + enemySize) / level.tileSize) * level.tileSize - enemySize;
+            e.velocityY[i] = 0.0f;
+            if (e.timer[i] <= 0.0f) {
+                e.velocityY[i] = -jumperJumpVelocity;
+                e.timer[i] = jumperJumpInterval;
+            }
+        }
+        e.y[i] = newY;
+    }
+}
+
+void EnemySystem::updateFlyers(int begin, int end, float timeDelta) {
+    auto& e = flyers;
+    for (int i = begin; i < end; ++i) {
+        e.timer[i] += timeDelta;
+
+        auto newX = e.x[i] + e.velocityX[i] * timeDelta;
+        auto aheadX = (e.velocityX[i] > 0.0f) ? newX + enemySize : newX;
+        if (isSolid(aheadX, e.y[i] + 1.0f) || isSolid(aheadX, e.y[i] + enemySize - 1.0f))
+            e.velocityX[i] = -e.velocityX[i];
+        else
+            e.x[i] = newX;
+
+        auto newY = e.baseY[i] + std::sin(e.timer[i] * flyerFrequency) * flyerAmplitude;
+        if (!isSolid(e.x[i] + 1.0f, newY) && !isSolid(e.x[i] + 1.0f, newY + enemySize))
+            e.y[i] = newY;
+    }
+}
+
+void EnemySystem::draw() const {
+    drawEnemies(patrols, MAROON);
+    drawEnemies(jumpers, PURPLE);
+    drawEnemies(flyers, DARKBLUE);
+}
+
+void EnemySystem::drawEnemies(const EnemyArrays& enemies, Color color) const {
+    for (int i = 0; i < enemies.size(); ++i) {
+        if (game.cull({ enemies.x[i], enemies.y[i], enemySize, enemySize }))
+            continue;
+        auto screenPosition = game.worldToScreen({ enemies.x[i], enemies.y[i] });
+        DrawRectangle(screenPosition.x, screenPosition.y, enemySize, enemySize, color);
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "raylib-cpp.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+class Game;
+class Level;
+
+
+enum class EnemyType {
+    PATROL,     ///< Walks along the ground, turns around at walls and ledges.
+    JUMPER,     ///< Jumps in place periodically.
+    FLYER,      ///< Flies in a wave, ignores gravity, turns around at walls.
+};
+
+/// Enemies of one archetype, stored as parallel arrays.
+struct EnemyArrays {
+    std::vector<float> x;           ///< Top-left corner, in world coordinates.
+    std::vector<float> y;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> timer;       ///< Time to next jump for jumpers, wave phase for flyers.
+    std::vector<float> baseY;       ///< Wave center for flyers.
+
+    int size() const { return static_cast<int>(std::ssize(x)); }
+    void clear();
+    void add(raylib::Vector2 position, float velocityX, float timer);
+};
+
+/// All enemies of a level. Update passes run in parallel chunks through Game::jobSystem.
+class EnemySystem {
+private:
+    Game& game;
+    Level& level;
+
+    EnemyArrays patrols;
+    EnemyArrays jumpers;
+    EnemyArrays flyers;
+
+    std::vector<uint8_t> chunkHits;     ///< One per chunk, so that chunks don't share writes.
+    bool playerHit = false;
+
+public:
+    static constexpr float enemySize = 14.0f;
+    static constexpr int chunkSize = 256;
+
+    float updateTime = 0.0f;            ///< Time of last update (in seconds).
+
+public:
+    EnemySystem(Game& game, Level& level) : game(game), level(level) {}
+
+    void clear();
+    void spawn(EnemyType type, raylib::Vector2 position);
+
+    /// Spawns enemies on random empty tiles. For stress levels.
+    void spawnRandom(EnemyType type, int count, uint32_t seed);
+
+    /// Loads "EnemyPatrol", "EnemyJumper" and "EnemyFlyer" LDtk entities.
+    void loadFromLdtk(const nlohmann::json& entities);
+
+    /// Moves enemies and checks if any of them touches the player hitbox.
+    void update(float timeDelta, raylib::Rectangle playerHitbox);
+    void draw() const;
+
+    bool isPlayerHit() const { return playerHit; }
+    int getEnemyCount() const { return patrols.size() + jumpers.size() + flyers.size(); }
+
+private:
+    void updatePatrols(int begin, int end, float timeDelta);
+    void updateJumpers(int begin, int end, float timeDelta);
+    void updateFlyers(int begin, int end, float timeDelta);
+
+    /// Runs update over enemies in chunks, and records player hits.
+    template<typename UpdateFunc>
+    void runPass(EnemyArrays& enemies, raylib::Rectangle playerHitbox, UpdateFunc updateFunc);
+
+    void drawEnemies(const EnemyArrays& enemies, Color color) const;
+
+    bool isSolid(float worldX, float worldY) const;
+};
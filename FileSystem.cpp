@@ -0,0 +1,218 @@
+#include "FileSystem.h"
+
+#include "ResourcePack.h"
+#include "PathInterner.h"
+#include "Utilities.h"
+
+#include "zstr.h"
+#include "zerrors.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+
+namespace {
+
+ResourcePack resourcePack;     ///< Not changed after initFileSystem(), so threads can read it without locking.
+
+std::atomic<int> looseOpens = 0;
+std::atomic<int> looseMisses = 0;
+std::atomic<int> packReads = 0;
+std::atomic<int64_t> readNanoseconds = 0;
+
+/// Adds time since construction to readNanoseconds.
+class ReadTimer {
+private:
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+public:
+    ~ReadTimer() { readNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count(); }
+};
+
+bool readLooseFile(const std::string& fileName, std::vector<unsigned char>& bytes) {
+    ++looseOpens;
+    auto file = std::fopen(fileName.c_str(), "rb");
+    if (!file) {
+        ++looseMisses;
+        return false;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    auto size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    bytes.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    auto read = std::fread(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+    ZASSERT(read == bytes.size()) << "Error while reading file: '" << fileName << "'.";
+    return true;
+}
+
+bool looseFileExists(const std::string& fileName) {
+    ++looseOpens;
+    std::error_code error;
+    if (std::filesystem::is_regular_file(fileName, error))
+        return true;
+    ++looseMisses;
+    return false;
+}
+
+/// @returns Pack entry that should be used for given file, or nullptr if loose file should be used.
+const PackEntry* findPackEntry(const std::string& fileName) {
+#if defined(USE_LOOSE_FILES)
+    if (!resourcePack.isOpen() || looseFileExists(fileName))
+        return nullptr;
+#endif
+    return resourcePack.find(PathInterner::normalize(fileName));
+}
+
+FileData readPackEntry(const PackEntry& entry) {
+    ++packReads;
+    auto stored = resourcePack.getStoredData(entry);
+    if (!(entry.flags & PACK_ENTRY_COMPRESSED))
+        return FileData(stored.data(), stored.size());
+
+    int size = 0;
+    auto decompressed = DecompressData(stored.data(), static_cast<int>(stored.size()), &size);
+    ZASSERT(decompressed && (size == static_cast<int>(entry.size))) << "Could not decompress '" << resourcePack.getName(entry) << "' from resource pack.";
+    std::vector<unsigned char> bytes(decompressed, decompressed + size);
+    MemFree(decompressed);
+    return FileData(std::move(bytes));
+}
+
+std::string getExtension(const std::string& fileName) {
+    return std::filesystem::path(fileName).extension().string();
+}
+
+// raylib frees what these return with MemFree().
+unsigned char* loadFileDataCallback(const char* fileName, int* dataSize) {
+    *dataSize = 0;
+    try {
+        auto file = readFile(fileName);
+        auto data = static_cast<unsigned char*>(MemAlloc(std::max(file.getSize(), 1)));
+        std::memcpy(data, file.getData(), file.getSize());
+        *dataSize = file.getSize();
+        return data;
+    }
+    catch (const std::exception& exc) {
+        TraceLog(LOG_WARNING, exc.what());
+        return nullptr;
+    }
+}
+
+char* loadFileTextCallback(const char* fileName) {
+    try {
+        auto file = readFile(fileName);
+        auto text = static_cast<char*>(MemAlloc(file.getSize() + 1));
+        std::memcpy(text, file.getData(), file.getSize());
+        text[file.getSize()] = '\0';
+        return text;
+    }
+    catch (const std::exception& exc) {
+        TraceLog(LOG_WARNING, exc.what());
+        return nullptr;
+    }
+}
+
+} // namespace
+
+
+FileData& FileData::operator=(FileData&& other) noexcept {
+    owned = std::move(other.owned); // Moving a vector keeps its buffer, so data stays valid.
+    data = other.data;
+    size = other.size;
+    other.data = nullptr;
+    other.size = 0;
+    return *this;
+}
+
+void initFileSystem(const std::string& packFile) {
+    if (resourcePack.open(packFile))
+        TraceLog(LOG_INFO, (ZSTR() << "Mounted resource pack '" << packFile << "' with " << resourcePack.getEntryCount() << " files").str().c_str());
+    else
+        TraceLog(LOG_INFO, (ZSTR() << "No resource pack '" << packFile << "', using loose files").str().c_str());
+
+    SetLoadFileDataCallback(loadFileDataCallback);
+    SetLoadFileTextCallback(loadFileTextCallback);
+}
+
+FileData readFile(const std::string& fileName) {
+    ReadTimer timer;
+
+    if (auto entry = findPackEntry(fileName))
+        return readPackEntry(*entry);
+
+    std::vector<unsigned char> bytes;
+    if (readLooseFile(fileName, bytes))
+        return FileData(std::move(bytes));
+
+    ZTHROW(FileNotFoundException()) << "Could not open input file: '" << fileName << "'.";
+}
+
+bool fileExists(const std::string& fileName) {
+    if (findPackEntry(fileName))
+        return true;
+#if defined(USE_LOOSE_FILES)
+    return !resourcePack.isOpen() && looseFileExists(fileName); // Otherwise findPackEntry() checked it already.
+#else
+    return looseFileExists(fileName);
+#endif
+}
+
+bool derivedFileExists(const std::string& derivedFile, [[maybe_unused]] const std::string& sourceFile) {
+#if defined(USE_LOOSE_FILES)
+    std::error_code error;
+    auto sourceTime = std::filesystem::last_write_time(sourceFile, error);
+    if (!error) {
+        // Loose source, it wins over the pack.
+        auto derivedTime = std::filesystem::last_write_time(derivedFile, error);
+        return !error && (derivedTime >= sourceTime);
+    }
+#endif
+    return fileExists(derivedFile);
+}
+
+std::string findConvertedImage(const std::string& fileName) {
+    std::filesystem::path path(fileName);
+    if (path.extension() != ".png")
+        return fileName;
+
+    auto convertedName = path.replace_extension(convertedImageExtension).string();
+    return derivedFileExists(convertedName, fileName) ? convertedName : fileName;
+}
+
+raylib::Image loadImageFile(const std::string& fileName) {
+    auto imageName = findConvertedImage(fileName);
+    auto file = readFile(imageName);
+    return raylib::Image(getExtension(imageName), file.getData(), file.getSize());
+}
+
+raylib::Wave loadWaveFile(const std::string& fileName) {
+    auto file = readFile(fileName);
+    return raylib::Wave(getExtension(fileName), file.getData(), file.getSize());
+}
+
+void loadMusicFile(raylib::Music& music, const std::string& fileName) {
+    ReadTimer timer;
+
+    if (auto entry = findPackEntry(fileName)) {
+        ZASSERT(!(entry->flags & PACK_ENTRY_COMPRESSED)) << "Music '" << fileName << "' can't be compressed in the resource pack, it is streamed.";
+        ++packReads;
+        auto data = resourcePack.getStoredData(*entry);
+        music.Load(getExtension(fileName), const_cast<unsigned char*>(data.data()), static_cast<int>(data.size())); // raylib doesn't write to it.
+        return;
+    }
+
+    ++looseOpens;
+    music.Load(fileName);
+}
+
+FileSystemStats getFileSystemStats() {
+    return FileSystemStats{ looseOpens, looseMisses, packReads, readNanoseconds / 1e9 };
+}
+
+int getResourcePackEntryCount() {
+    return resourcePack.getEntryCount();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "raylib-cpp.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/// Contents of a file. Either a view into the mounted resource pack, or owned bytes.
+class FileData {
+private:
+    std::vector<unsigned char> owned;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+public:
+    FileData() = default;
+    FileData(const unsigned char* view, size_t size) : data(view), size(size) {}
+    explicit FileData(std::vector<unsigned char> bytes) : owned(std::move(bytes)), data(owned.data()), size(owned.size()) {}
+    FileData(FileData&& other) noexcept { *this = std::move(other); }
+    FileData& operator=(FileData&& other) noexcept;
+
+    const unsigned char* getData() const { return data; }
+    int getSize() const { return static_cast<int>(size); }
+    std::string_view getText() const { return { reinterpret_cast<const char*>(data), size }; }
+};
+
+/// Counters of file accesses. Compare them with and without a resource pack.
+struct FileSystemStats {
+    int looseOpens = 0;         ///< Loose files opened (or checked for) on disk.
+    int looseMisses = 0;        ///< Loose files that weren't there.
+    int packReads = 0;          ///< Files read from the resource pack.
+    double readTime = 0.0;      ///< Time spent opening and reading files (in seconds).
+};
+
+// Virtual file system. Files come from a mounted resource pack, or from the disk (loose files).
+// If the game is built with USE_LOOSE_FILES loose files win, so that they can be edited without rebuilding the pack.
+// Otherwise the pack wins, and loose files are only a fallback. Safe to call from any thread, after mounting.
+
+/// Mounts resource pack, and routes raylib's file loading through the file system.
+/// Missing pack is fine, then only loose files are used.
+void initFileSystem(const std::string& packFile);
+
+/// Reads whole file. Throws FileNotFoundException if it's neither loose, nor in the pack.
+FileData readFile(const std::string& fileName);
+
+/// @returns True if file is loose, or in the pack.
+bool fileExists(const std::string& fileName);
+
+/// @returns True if file made by a tool from sourceFile exists.
+///          With USE_LOOSE_FILES loose files older than a loose source are ignored, so edited sources show up right away.
+bool derivedFileExists(const std::string& derivedFile, const std::string& sourceFile);
+
+/// Extension of images converted by Tools/AssetConverter.cpp. QOI decodes several times faster than PNG.
+constexpr const char* convertedImageExtension = ".qoi";
+
+/// @returns Converted version of given PNG image, or fileName if there is none.
+///          With USE_LOOSE_FILES converted loose files older than the source are ignored, so edited PNGs show up right away.
+std::string findConvertedImage(const std::string& fileName);
+
+/// Loads image (converted version, if there is one) from the pack without copying it.
+raylib::Image loadImageFile(const std::string& fileName);
+raylib::Wave loadWaveFile(const std::string& fileName);
+
+/// Music is streamed, so from the pack it streams straight from the mapped memory.
+void loadMusicFile(raylib::Music& music, const std::string& fileName);
+
+FileSystemStats getFileSystemStats();
+int getResourcePackEntryCount();
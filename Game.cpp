@@ -1,10 +1,15 @@
 #include "Game.h"
 
 #include "Utilities.h"
+#include "AllocationCounter.h"
+#include "FileSystem.h"
 
 #include "zstr.h"
 #include "zerrors.h"
 
+#include <algorithm>
+#include <filesystem>
+
 
 raylib::Vector2 Game::worldToScreen(raylib::Vector2 worldPosition) const {
     auto delta = worldPosition - cameraPosition;
@@ -15,33 +20,21 @@ raylib::Vector2 Game::screenToWorld(raylib::Vector2 screenPosition) const {
     return { screenPosition.x - screenWidth / 2 + cameraPosition.x, (screenPosition.y - screenHeight / 2) + cameraPosition.y };
 }
 
-void Game::drawHud(bool withTotals) {
-    if (!withTotals) {
-        auto startX = 1200.0f;
-        auto startY = 30.0f;
-        auto [collectedCount, totalCount] = level.getCollectibleStats();
-        hudCollectible.position = raylib::Vector2{ startX, startY };
-        hudCollectible.update();
-        hudFont.DrawText((ZSTR() << collectedCount).str(), raylib::Vector2{ startX + 30.0f, startY - 20.0f }, 40.0f, 1.0f, GOLD);
-    } else {
-        auto startX = 100.0f;
-        auto startY = 250.0f;
-        auto [collectedCount, totalCount] = level.getCollectibleStats();
-
-        auto& futFont = menu.useFuthark ? menu.futharkFont : hudFont;
-
-        hudCollectible.position = raylib::Vector2{ startX, startY };
-        hudCollectible.update();
-        hudFont.DrawText((ZSTR() << collectedCount << " / " << totalCount).str(), raylib::Vector2{ startX + 30.0f, startY - 20.0f }, 40.0f, 1.0f, GOLD);
-        futFont.DrawText(textForFont(!menu.useFuthark, false, U"w poziomie"), raylib::Vector2{ startX + 140.0f, startY - 20.0f }, 40.0f, 1.0f, GOLD);
+raylib::Rectangle Game::getCameraView() const {
+    return { screenToWorld(raylib::Vector2::Zero()), raylib::Vector2{ static_cast<float>(screenWidth), static_cast<float>(screenHeight) } };
+}
 
-        startX = 930.0f;
-        startY = 250.0f;
-        hudCollectible.position = raylib::Vector2{ startX, startY };
-        hudCollectible.update();
-        hudFont.DrawText((ZSTR() << totalCollected << " / " << totalAvailable).str(), raylib::Vector2{ startX + 30.0f, startY - 20.0f }, 40.0f, 1.0f, GOLD);
-        futFont.DrawText(textForFont(!menu.useFuthark, false, U"w sumie"), raylib::Vector2{ startX + 140.0f, startY - 20.0f }, 40.0f, 1.0f, GOLD);
+bool Game::cull(raylib::Rectangle worldBounds) {
+    if (getCameraView().CheckCollision(worldBounds)) {
+        ++drawsSubmitted;
+        return false;
     }
+    ++drawsCulled;
+    return true;
+}
+
+void Game::drawHud(bool withTotals) {
+    hud.draw(withTotals);
 }
 
 void Game::cameraUpdate() {
@@ -67,6 +60,7 @@ void Game::cameraUpdate() {
     if (cameraView.y + cameraView.height > level.levelHeight) cameraWindow.y -= (cameraView.y + cameraView.height) - level.levelHeight;
 
     cameraPosition = cameraWindow.GetPosition() + cameraWindow.GetSize() / 2.0f;
+    soundService.setListener(cameraPosition);
 }
 
 void Game::restartGame() {
@@ -78,6 +72,7 @@ void Game::restartGame() {
     gameState = GameState::START_SCREEN;
     totalCollected = 0;
     totalAvailable = 0;
+    updateSceneResidency();
     startScreen.startScene();
     currentLevel = 0;
     currentEpisode.clear();
@@ -94,8 +89,15 @@ void Game::startLevel(int levelIndex) {
     currentLevel = levelIndex;
     ZASSERT(episodes.contains(currentEpisode));
     ZASSERT(currentLevel < std::ssize(episodes.at(currentEpisode)));
+    auto loadStartTime = GetTime();
+    auto loadStartAllocations = getAllocationCount();
+    auto loadStartUnderruns = musicManager.getUnderrunCount();
+    levelGenerator.waitForPregeneration(); // Usually done long ago, while level end screen was shown.
     level.load(episodes.at(currentEpisode)[currentLevel]);
     level.startLevel();
+    updateSceneResidency(); // After level load, so that prefetching scenes doesn't delay it.
+    std::string allocations = allocationCountingEnabled ? (ZSTR() << getAllocationCount() - loadStartAllocations << " allocations, ").str() : "";
+    TraceLog(LOG_INFO, (ZSTR() << "Level " << levelIndex + 1 << " loaded in " << (GetTime() - loadStartTime) * 1000.0 << " ms, " << allocations << musicManager.getUnderrunCount() - loadStartUnderruns << " music underruns").str().c_str());
     cameraPosition = player.position;
     cameraUpdate();
     waitUntilJumpNotPressed = true;
@@ -109,16 +111,20 @@ void Game::endLevel(bool died) {
 
     if (died) {
         gameState = GameState::LEVEL_DIED;
+        updateSceneResidency();
         deadScreen.startScene();
     }
     else
     {
         if (currentLevel < std::ssize(episodes.at(currentEpisode)) - 1) {
             gameState = GameState::LEVEL_SUCCESS;
+            updateSceneResidency();
             levelEndScreen.startScene();
+            levelGenerator.pregenerate(episodes.at(currentEpisode)[currentLevel + 1]); // In the background, so generated levels are ready when player presses continue.
         }
         else {
             gameState = GameState::GAME_SUCCESS;
+            updateSceneResidency();
             gameEndScreen.startScene();
         }
 
@@ -159,8 +165,43 @@ void Game::drawFrame()
             endLevel(true);
         if (IsKeyPressed(KEY_R))
             restartGame();
+        if (IsKeyPressed(KEY_C) && (gameState == GameState::LEVEL))
+            level.addStressColliders(500);
+        if (IsKeyPressed(KEY_X) && (gameState == GameState::LEVEL)) {
+            level.enemies.spawnRandom(EnemyType::PATROL, 1000, level.enemies.getEnemyCount());
+            level.enemies.spawnRandom(EnemyType::JUMPER, 1000, level.enemies.getEnemyCount() + 1);
+            level.enemies.spawnRandom(EnemyType::FLYER, 1000, level.enemies.getEnemyCount() + 2);
+        }
+        if (IsKeyPressed(KEY_V) && (gameState == GameState::LEVEL))
+            level.addStressCollectibles(10000);
+        if (IsKeyPressed(KEY_L))
+            level.useStaticLayerCache = !level.useStaticLayerCache;
+        if (IsKeyPressed(KEY_M)) {
+            logSceneResidencyCycles(5);
+            resourceCache.logReport();
+        }
+        if (IsKeyPressed(KEY_K))
+            resourceCache.benchmarkLookups(1000000);
+        if (IsKeyPressed(KEY_LEFT_BRACKET))
+            musicManager.setBufferFrames(std::max(1024, musicManager.getBufferFrames() / 2));
+        if (IsKeyPressed(KEY_RIGHT_BRACKET))
+            musicManager.setBufferFrames(musicManager.getBufferFrames() * 2);
+        if (IsKeyPressed(KEY_U))
+            musicManager.resetStats();
+        if (IsKeyPressed(KEY_B)) {
+            player.runAnimation.benchmark(1000000);
+            player.idleAnimation.benchmark(1000000);
+            collectiblePrefab.wiggleAnimation.benchmark(1000000);
+        }
     }
 
+    resourceCache.update();
+    musicManager.update();
+    level.buildStaticLayerCaches(); // Before BeginDrawing(), because it draws to render textures.
+    spriteBatch.beginFrame();
+    drawsSubmitted = 0;
+    drawsCulled = 0;
+
     BeginDrawing();
     window.ClearBackground(RAYWHITE);
 
@@ -173,33 +214,25 @@ void Game::drawFrame()
         {
             levelTimeDelta = window.GetFrameTime();
             levelTime += window.GetFrameTime();
+            collectiblePrefab.update(levelTimeDelta);
 
+            level.updateDynamicColliders();
             player.update();
+            level.enemies.update(levelTimeDelta, player.getWorldHitbox());
             cameraUpdate();
+            level.updateTriggers();
 
             level.drawBackground();
             player.draw();
             level.update();
+            level.updateStressReport();
 
             drawHud(false);
 
-            if (level.levelExit.CheckCollision(player.position)) {
-                endLevelByDeath = false;
-                level.setLevelEnding(false);
-                player.setPlayerDead(false);
-            }
-
-            if (level.furharkTrigger.CheckCollision(player.position)) {
-                level.setShowFuthark();
-            }
-
-            if (player.state == PlayerState::GROUNDED) {
-                auto playerTile = level.getTileWorld(player.position + raylib::Vector2(0, level.tileSize / 2.0f)).value_or(TileType::EMPTY);
-                if (playerTile == TileType::LAVA) {
-                    endLevelByDeath = true;
-                    level.setLevelEnding(true);
-                    player.setPlayerDead(true);
-                }
+            if (level.enemies.isPlayerHit() && !player.playerDead) {
+                endLevelByDeath = true;
+                level.setLevelEnding(true);
+                player.setPlayerDead(true);
             }
 
             if (level.hasLevelEnded()) {
@@ -209,8 +242,6 @@ void Game::drawFrame()
         else {
             levelTimeDelta = 0;
         }
-
-        level.music.Update(); // We want to update music even if level update was not called.
     }
     else
         if (gameState == GameState::START_SCREEN)
@@ -221,6 +252,7 @@ void Game::drawFrame()
         if (gameState == GameState::LEVEL_SUCCESS)
         {
             levelEndScreen.update();
+            collectiblePrefab.update(levelTimeDelta);
             drawHud(true);
             if (levelEndScreen.areAnimationsFinished()) {
                 if (!menu.isInMenu() && isInputPressed(InputButton::MENU_ACTION)) { // A
@@ -244,6 +276,7 @@ void Game::drawFrame()
         if (gameState == GameState::GAME_SUCCESS)
         {
             gameEndScreen.update();
+            collectiblePrefab.update(levelTimeDelta);
             drawHud(true);
             if (gameEndScreen.areAnimationsFinished()) {
                 if (isInputPressed(InputButton::MENU_ACTION)) { // A
@@ -253,6 +286,8 @@ void Game::drawFrame()
             }
         }
 
+    flushSprites();
+
     if (!hackDisableMenuUpdate)
         menu.draw();
 
@@ -264,7 +299,7 @@ void Game::drawFrame()
 
         // Debug HitBox
 #if 0
-        hitbox.SetSize(player.hitbox.GetSize());
+        hitbox.SetSize(player.physics.hitbox.GetSize());
         if (gamepad.IsButtonPressed(GAMEPAD_BUTTON_RIGHT_THUMB)) {
             hitboxVelocity.x = gamepad.GetAxisMovement(GAMEPAD_AXIS_RIGHT_X) * (gamepad.IsButtonDown(GAMEPAD_BUTTON_RIGHT_TRIGGER_1) ? 10.0f : 50.0f);
             hitboxVelocity.y = gamepad.GetAxisMovement(GAMEPAD_AXIS_RIGHT_Y) * (gamepad.IsButtonDown(GAMEPAD_BUTTON_RIGHT_TRIGGER_1) ? 10.0f : 50.0f);
@@ -287,10 +322,39 @@ void Game::drawFrame()
         DrawText((ZSTR() << "MOVE DELTA X: " << moveDelta.x << " Y: " << moveDelta.y).str().c_str(), 10, 330, 10, BLACK);
 #endif
 
+        auto fileStats = getFileSystemStats();
+        auto& soundStats = soundService.getStats();
+        DrawText((ZSTR() << "SFX: VOICES: " << soundService.getActiveVoiceCount() << "/" << SoundService::voiceCount << " PLAYED: " << soundStats.played << " LIMITED: " << soundStats.limited << " STOLEN: " << soundStats.stolen << " DROPPED: " << soundStats.dropped << " CULLED: " << soundStats.culled).str().c_str(), 10, 550, 10, RED);
+        DrawText((ZSTR() << "MUSIC: STREAMS: " << musicManager.getStreamCount() << " LOADS: " << musicManager.getLoadCount() << " BUFFER: " << musicManager.getBufferFrames() << " FRAMES UNDERRUNS: " << musicManager.getUnderrunCount() << " MAX REFILL GAP: " << musicManager.getMaxRefillGap() * 1000.0 << " ms").str().c_str(), 10, 560, 10, RED);
+        std::string residency = "SCENES:";
+        for (auto screen : { &startScreen, &deadScreen, &levelEndScreen, &gameEndScreen })
+            residency += (ZSTR() << " " << std::filesystem::path(screen->getSceneFile()).stem().string() << (screen->isResident() ? ": RESIDENT" : ": RELEASED")).str();
+        DrawText(residency.c_str(), 10, 570, 10, RED);
+        DrawText((ZSTR() << "FILES: LOOSE OPENS: " << fileStats.looseOpens << " MISSING: " << fileStats.looseMisses << " PACK READS: " << fileStats.packReads << " (" << getResourcePackEntryCount() << " IN PACK) READ TIME: " << fileStats.readTime * 1000.0 << " ms").str().c_str(), 10, 580, 10, RED);
+        DrawText((ZSTR() << "PENDING LOADS: " << resourceCache.getPendingLoadCount() << " STALLED FRAMES: " << resourceCache.getStalledFrames() << " LAST STALL: " << resourceCache.getLastFrameStallTime() * 1000.0 << " ms").str().c_str(), 10, 590, 10, RED);
         DrawText((ZSTR() << "GAME STATE: " << to_string(gameState)).str().c_str(), 10, 600, 10, RED);
+        DrawText((ZSTR() << "DYNAMIC COLLIDERS: " << level.getDynamicColliderCount() << " TESTS: " << level.dynamicColliderTests << " UPDATE: " << level.dynamicCollidersTime * 1000.0f << " ms").str().c_str(), 10, 610, 10, RED);
+        DrawText((ZSTR() << "ENEMIES: " << level.enemies.getEnemyCount() << " UPDATE: " << level.enemies.updateTime * 1000.0f << " ms WORKERS: " << jobSystem.getWorkerCount()).str().c_str(), 10, 620, 10, RED);
+        DrawText((ZSTR() << "COLLECTIBLES: " << std::get<1>(level.getCollectibleStats()) << " DRAWN: " << level.collectiblesDrawn << " DRAW: " << level.collectiblesTime * 1000.0f << " ms").str().c_str(), 10, 630, 10, RED);
+        DrawText((ZSTR() << "SPRITES: " << spriteBatch.spriteCount << " BATCHES: " << spriteBatch.batchCount << " TEXTURE SWITCHES: " << spriteBatch.textureSwitches << " ATLAS PAGES: " << resourceCache.getAtlasPageCount()).str().c_str(), 10, 640, 10, RED);
+        DrawText((ZSTR() << "STATIC LAYER CACHE: " << (level.useStaticLayerCache ? "ON" : "OFF") << " FRAME: " << window.GetFrameTime() * 1000.0f << " ms").str().c_str(), 10, 650, 10, RED);
+        DrawText((ZSTR() << "WORLD DRAWS SUBMITTED: " << drawsSubmitted << " CULLED: " << drawsCulled).str().c_str(), 10, 660, 10, RED);
+        DrawText((ZSTR() << "TEXT CACHE ENTRIES: " << textCache.getEntryCount() << " CONVERSIONS: " << textCache.getConversionCount()).str().c_str(), 10, 670, 10, RED);
+        DrawText((ZSTR() << "RESOURCES: " << resourceCache.getEntryCount() << " RAM: " << resourceCache.getRamBytes() / (1024 * 1024) << " / " << resourceCache.getRamBudget() / (1024 * 1024) << " MB VRAM: " << resourceCache.getVramBytes() / (1024 * 1024) << " / " << resourceCache.getVramBudget() / (1024 * 1024) << " MB EVICTIONS: " << resourceCache.getEvictionCount()).str().c_str(), 10, 680, 10, RED);
+        auto consumerY = 690;
+        for (auto entry : resourceCache.getTopConsumers(3)) {
+            DrawText((ZSTR() << "    " << resourceKindName(entry->kind) << " " << entry->name << ": " << (entry->ramBytes + entry->vramBytes) / 1024 << " KB, " << entry->refCount << " HANDLES").str().c_str(), 10, consumerY, 10, RED);
+            consumerY += 10;
+        }
     }
 
     EndDrawing();
+
+    if (!firstFrameDrawn) {
+        firstFrameDrawn = true;
+        auto stats = getFileSystemStats();
+        TraceLog(LOG_INFO, (ZSTR() << "Cold start: first frame " << GetTime() * 1000.0 << " ms after window creation, " << stats.looseOpens << " loose file opens (" << stats.looseMisses << " missing), " << stats.packReads << " resource pack reads, " << stats.readTime * 1000.0 << " ms reading files").str().c_str());
+    }
     //----------------------------------------------------------------------------------
 }
 
@@ -303,24 +367,83 @@ void Game::mainLoop()
     }
 }
 
-void Game::drawSprite(raylib::Vector2 worldPosition, const raylib::Texture2D& sprite, raylib::Vector2 spriteOrigin, bool horizontalMirror) const {
+void Game::drawSprite(raylib::Vector2 worldPosition, const Sprite& sprite, raylib::Vector2 spriteOrigin, bool horizontalMirror, SpriteLayer layer) {
     raylib::Vector2 screenPosition;
-    if (!horizontalMirror) {
+    if (!horizontalMirror)
         screenPosition = worldToScreen(worldPosition - spriteOrigin);
-        sprite.Draw(screenPosition);
-    }
-    else {
+    else
         screenPosition = worldToScreen(worldPosition - raylib::Vector2(sprite.GetSize().x - spriteOrigin.x, spriteOrigin.y));
-        sprite.Draw(raylib::Rectangle { raylib::Vector2::Zero(), raylib::Vector2{-1.0f, 1.0f} * sprite.GetSize() }, raylib::Rectangle { screenPosition, sprite.GetSize() });
+
+    // Callers are expected to cull before looking up the sprite, so this only catches what they didn't, and isn't counted.
+    if (!raylib::Rectangle{ 0.0f, 0.0f, static_cast<float>(screenWidth), static_cast<float>(screenHeight) }.CheckCollision(raylib::Rectangle{ screenPosition, sprite.GetSize() }))
+        return;
+    spriteBatch.add(sprite, raylib::Rectangle { screenPosition, sprite.GetSize() }, horizontalMirror, static_cast<int>(layer));
+}
+
+void Game::drawSpriteOnScreen(raylib::Vector2 screenPosition, const Sprite& sprite, int layer) {
+    spriteBatch.add(sprite, raylib::Rectangle { screenPosition, sprite.GetSize() }, false, layer);
+}
+
+void Game::setScenesUseFuthark(bool useFuthark) {
+    for (auto screen : { &startScreen, &deadScreen, &levelEndScreen, &gameEndScreen })
+        screen->setUseFuthark(useFuthark);
+}
+
+Scene* Game::getStateScene(GameState state) {
+    switch (state) {
+        case GameState::START_SCREEN: return &startScreen;
+        case GameState::LEVEL_DIED: return &deadScreen;
+        case GameState::LEVEL_SUCCESS: return &levelEndScreen;
+        case GameState::GAME_SUCCESS: return &gameEndScreen;
+        default: return nullptr;
     }
 }
 
-void Game::reloadScenes(bool useFuthark, bool reloadHack) {
-    startScreen.load("Scenes/StartScreen.json", useFuthark, reloadHack);
-    deadScreen.load("Scenes/DeadScreen.json", useFuthark, reloadHack);
-    levelEndScreen.load("Scenes/LevelEndScreen.json", useFuthark, reloadHack);
-    gameEndScreen.load("Scenes/GameEndScreen.json", useFuthark, reloadHack);
-    startScreen.startScene(reloadHack); // @hack
+void Game::updateSceneResidency() {
+    // Scenes that can be shown after the current state are prefetched in the background.
+    std::vector<Scene*> prefetch;
+    if (gameState == GameState::LEVEL) {
+        prefetch.push_back(&deadScreen);
+        if (currentLevel < std::ssize(episodes.at(currentEpisode)) - 1)
+            prefetch.push_back(&levelEndScreen);
+        else
+            prefetch.push_back(&gameEndScreen);
+    }
+    else if (gameState == GameState::GAME_SUCCESS) {
+        prefetch.push_back(&startScreen);
+    }
+
+    auto current = getStateScene(gameState);
+    for (auto screen : { &startScreen, &deadScreen, &levelEndScreen, &gameEndScreen }) {
+        if ((screen != current) && (std::find(prefetch.begin(), prefetch.end(), screen) == prefetch.end()))
+            screen->release();
+    }
+
+    if (current) {
+        // Scene may have been prefetched, and may still be loading.
+        current->makeResident(ResourceCache::loadNow);
+        resourceCache.waitForGroup(sceneLoadGroup);
+    }
+    for (auto screen : prefetch)
+        screen->makeResident(sceneLoadGroup);
+}
+
+void Game::logSceneResidencyCycles(int cycles) {
+    auto current = getStateScene(gameState);
+    for (int cycle = 1; cycle <= cycles; ++cycle) {
+        for (auto screen : { &startScreen, &deadScreen, &levelEndScreen, &gameEndScreen }) {
+            if (screen != current)
+                screen->release();
+        }
+        for (auto screen : { &startScreen, &deadScreen, &levelEndScreen, &gameEndScreen }) {
+            if (screen != current)
+                screen->makeResident(sceneLoadGroup);
+        }
+        resourceCache.waitForGroup(sceneLoadGroup);
+        resourceCache.waitForGroup(scriptVariantLoadGroup);
+        TraceLog(LOG_INFO, (ZSTR() << "Scene residency cycle " << cycle << ": " << resourceCache.getAtlasPageCount() << " atlas pages, RAM " << resourceCache.getRamBytes() / 1024 << " KB, VRAM " << resourceCache.getVramBytes() / 1024 << " KB").str().c_str());
+    }
+    updateSceneResidency(); // Back to scenes needed in the current state.
 }
 
 bool Game::isInputDown(InputButton button) const {
@@ -353,6 +476,7 @@ bool Game::isInputPressed(InputButton button) const {
 
 void Game::load(const std::string& levelFile) {
     episodes.clear();
+    debugEpisodes.clear();
 
     // Custom data
     auto jsonText = loadTextFile(levelFile);
@@ -361,6 +485,8 @@ void Game::load(const std::string& levelFile) {
 
     for (auto episode : json["episodes"]) {
         auto episodeName = loadUnicodeStringFromJson(episode, "name");
+        if (episode.value("debug", false))
+            debugEpisodes.insert(episodeName); // Test levels are only shown in debug mode.
         for (auto levelFile : episode["levels"]) {
             auto levelPath = levelFile.get<std::string>();
             episodes[episodeName].emplace_back((basePath / levelPath).string());
@@ -3,13 +3,21 @@
 #include "Menu.h"
 #include "Player.h"
 #include "Level.h"
+#include "LevelGenerator.h"
 #include "Collectible.h"
 #include "Scene.h"
 #include "ResourceCache.h"
+#include "SpriteBatch.h"
+#include "Hud.h"
+#include "TextCache.h"
+#include "JobSystem.h"
+#include "MusicManager.h"
+#include "SoundService.h"
 
 #include "raylib-cpp.hpp"
 
 #include <map>
+#include <set>
 
 
 enum class InputButton {
@@ -48,12 +56,15 @@ class Game
 {
 public:
     ResourceCache resourceCache;    ///< We want to destroy it last, so we need to put it first.
+    JobSystem jobSystem;
 
     const int screenWidth = 1280;
     const int screenHeight = 720;
 
     raylib::Window window;
     raylib::AudioDevice audioDevice;
+    MusicManager musicManager;      ///< After audioDevice, so streams are unloaded before the device is closed.
+    SoundService soundService;      ///< Same as musicManager. All sound effects go through it.
     raylib::Gamepad gamepad;
     raylib::Font hudFont;
 
@@ -64,6 +75,7 @@ public:
     Menu menu;
 
     std::map<std::u32string, std::vector<std::string>> episodes;
+    std::set<std::u32string> debugEpisodes;    ///< Episodes shown only in debug mode.
     std::u32string currentEpisode; ///< Current or last episode played.
     int currentLevel = 0;       ///< Current or last level played.
     int totalCollected = 0;     ///< Number of collected collectibles.
@@ -71,34 +83,49 @@ public:
     raylib::Vector2 cameraPosition = { 0, 0 }; ///< Camera position in world coordinates.
     Player player;
     Level level;
+    LevelGenerator levelGenerator;
     CollectiblePrefab collectiblePrefab;
-    Collectible hudCollectible;                 ///< For drawing on HUD.
+    Hud hud;
 
+    static constexpr int sceneLoadGroup = 0;   ///< ResourceCache load group of prefetched scenes.
+    static constexpr int scriptVariantLoadGroup = 1;   ///< ResourceCache load group of scene images in the script that isn't shown.
     Scene startScreen;
     Scene deadScreen;
     Scene levelEndScreen;
     Scene gameEndScreen;
 
     bool debug = false;
+    bool firstFrameDrawn = false;
     bool endLevelByDeath = false;
     bool waitUntilJumpNotPressed = false;   ///< Don't count jump press that closes menu.
 
+    SpriteBatch spriteBatch;                ///< All sprites go through it.
+    TextCache textCache;                    ///< All UI text goes through it.
+    int drawsSubmitted = 0;                 ///< World-space draws that passed culling during current frame.
+    int drawsCulled = 0;                    ///< World-space draws skipped by culling during current frame.
+
 public:
     Game()
         : window(screenWidth, screenHeight, "Kunek Bogus")
+        , soundService(resourceCache)
         , menu(*this)
         , player(*this)
         , level(*this)
+        , levelGenerator(*this)
         , collectiblePrefab(*this)
-        , hudCollectible(collectiblePrefab)
+        , hud(*this)
         , hudFont("Graphics/Fonts/jupiter_crash.png")
         , startScreen(*this)
         , deadScreen(*this)
         , levelEndScreen(*this)
         , gameEndScreen(*this)
     {
-        hudCollectible.forHud = true;
-        reloadScenes(menu.useFuthark, false);
+        startScreen.setSource("Scenes/StartScreen.json", menu.useFuthark);
+        deadScreen.setSource("Scenes/DeadScreen.json", menu.useFuthark);
+        levelEndScreen.setSource("Scenes/LevelEndScreen.json", menu.useFuthark);
+        gameEndScreen.setSource("Scenes/GameEndScreen.json", menu.useFuthark);
+        updateSceneResidency();
+        startScreen.startScene();
         load("Levels/Levels.json");
     }
 
@@ -108,7 +135,22 @@ public:
     raylib::Vector2 worldToScreen(raylib::Vector2 worldPosition) const;
     raylib::Vector2 screenToWorld(raylib::Vector2 screenPosition) const;
 
-    void drawSprite(raylib::Vector2 worldPosition, const raylib::Texture2D& sprite, raylib::Vector2 spriteOrigin, bool horizontalMirror) const;
+    /// @returns Part of the world visible on screen, in world coordinates.
+    raylib::Rectangle getCameraView() const;
+
+    /// Culling test for world-space draws. Call it before doing any work needed for drawing.
+    /// @returns True if worldBounds are off screen, and the draw should be skipped.
+    bool cull(raylib::Rectangle worldBounds);
+
+    /// Counts draws that were culled in bulk (for example by a grid), for the debug overlay.
+    void countDraws(int submitted, int culled) { drawsSubmitted += submitted; drawsCulled += culled; }
+
+    /// Sprites are drawn on next flushSprites(), sorted by layer.
+    void drawSprite(raylib::Vector2 worldPosition, const Sprite& sprite, raylib::Vector2 spriteOrigin, bool horizontalMirror, SpriteLayer layer);
+    void drawSpriteOnScreen(raylib::Vector2 screenPosition, const Sprite& sprite, int layer = static_cast<int>(SpriteLayer::HUD));
+
+    /// Draws sprites recorded so far. Call before drawing anything (other than sprites) that has to be on top of them.
+    void flushSprites() { spriteBatch.flush(); }
 
     void drawHud(bool withTotals);
     void cameraUpdate();
@@ -117,7 +159,19 @@ public:
     void startLevel(int levelIndex);
     void endLevel(bool died);
 
-    void reloadScenes(bool useFuthark, bool reloadHack);
+    /// Switches script of all scenes. Doesn't load anything.
+    void setScenesUseFuthark(bool useFuthark);
+
+    /// @returns Scene shown in given state, or nullptr.
+    Scene* getStateScene(GameState state);
+
+    /// Loads scene of the current gameState, prefetches scenes of states that can come next, and releases other ones.
+    /// Must be called after every gameState change.
+    void updateSceneResidency();
+
+    /// Releases and reloads all scenes that aren't shown, as if the player went through that many level ends and deaths,
+    /// and logs resource cache memory after every cycle. Memory (and atlas page count) should stay flat.
+    void logSceneResidencyCycles(int cycles);
 
     bool isInputDown(InputButton button) const;
     bool isInputPressed(InputButton button) const;
@@ -0,0 +1,47 @@
+#include "GlyphRun.h"
+
+#include <algorithm>
+
+
+void GlyphRun::layout(const ::Font& font, const std::string& text, float fontSize, float spacing) {
+    texture = font.texture;
+    glyphs.clear();
+
+    auto scale = fontSize / font.baseSize;
+    auto padding = static_cast<float>(font.glyphPadding);
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+    float width = 0.0f;
+
+    for (size_t i = 0; i < text.size(); ) {
+        int codepointSize = 0;
+        auto codepoint = GetCodepoint(text.c_str() + i, &codepointSize);
+        i += std::max(codepointSize, 1);
+
+        if (codepoint == '\n') {
+            offsetY += fontSize * 1.5f; // Same as raylib's default line spacing.
+            offsetX = 0.0f;
+            continue;
+        }
+
+        auto index = GetGlyphIndex(font, codepoint);
+        const auto& rec = font.recs[index];
+        const auto& glyph = font.glyphs[index];
+
+        if ((codepoint != ' ') && (codepoint != '\t')) {
+            raylib::Rectangle source{ rec.x - padding, rec.y - padding, rec.width + 2.0f * padding, rec.height + 2.0f * padding };
+            raylib::Rectangle destination{ offsetX + glyph.offsetX * scale - padding * scale, offsetY + glyph.offsetY * scale - padding * scale, source.width * scale, source.height * scale };
+            glyphs.push_back(Glyph{ source, destination });
+        }
+
+        offsetX += ((glyph.advanceX == 0) ? rec.width : static_cast<float>(glyph.advanceX)) * scale + spacing;
+        width = std::max(width, offsetX);
+    }
+
+    size = raylib::Vector2{ width, offsetY + fontSize };
+}
+
+void GlyphRun::draw(SpriteBatch& spriteBatch, raylib::Vector2 position, ::Color tint, int layer) const {
+    for (const auto& glyph : glyphs)
+        spriteBatch.addQuad(texture, glyph.source, raylib::Rectangle{ position + glyph.destination.GetPosition(), glyph.destination.GetSize() }, tint, layer);
+}
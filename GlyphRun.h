@@ -0,0 +1,31 @@
+#pragma once
+
+#include "SpriteBatch.h"
+
+#include "raylib-cpp.hpp"
+
+#include <string>
+#include <vector>
+
+
+/// Text laid out once into glyph quads, the same way raylib's DrawTextEx() does it.
+/// Drawing it doesn't decode UTF-8 or look up glyphs, and goes through the SpriteBatch.
+class GlyphRun {
+private:
+    struct Glyph {
+        raylib::Rectangle source;       ///< In font texture.
+        raylib::Rectangle destination;  ///< Relative to the position of the run.
+    };
+
+    ::Texture2D texture = {};           ///< Font texture.
+    std::vector<Glyph> glyphs;
+    raylib::Vector2 size = { 0.0f, 0.0f };
+
+public:
+    /// @param text     UTF-8 text. Can contain new lines.
+    void layout(const ::Font& font, const std::string& text, float fontSize, float spacing);
+
+    void draw(SpriteBatch& spriteBatch, raylib::Vector2 position, ::Color tint, int layer) const;
+
+    raylib::Vector2 getSize() const { return size; }
+};
@@ -0,0 +1,51 @@
+#include "Hud.h"
+
+#include "Game.h"
+#include "Utilities.h"
+
+#include "zstr.h"
+
+
+void Hud::update() {
+    auto [collectedCount, totalCount] = game.level.getCollectibleStats();
+
+    if ((collectedCount != shownCollected) || (totalCount != shownAvailable)) {
+        levelCountText.layout(game.hudFont, (ZSTR() << collectedCount).str(), 40.0f, 1.0f);
+        levelStatsText.layout(game.hudFont, (ZSTR() << collectedCount << " / " << totalCount).str(), 40.0f, 1.0f);
+        shownCollected = collectedCount;
+        shownAvailable = totalCount;
+    }
+
+    if ((game.totalCollected != shownTotalCollected) || (game.totalAvailable != shownTotalAvailable)) {
+        totalStatsText.layout(game.hudFont, (ZSTR() << game.totalCollected << " / " << game.totalAvailable).str(), 40.0f, 1.0f);
+        shownTotalCollected = game.totalCollected;
+        shownTotalAvailable = game.totalAvailable;
+    }
+}
+
+void Hud::draw(bool withTotals) {
+    update();
+
+    auto layer = static_cast<int>(SpriteLayer::HUD);
+    auto useFuthark = game.menu.useFuthark;
+    auto& futFont = useFuthark ? game.menu.futharkFont : game.hudFont;
+
+    if (!withTotals) {
+        auto startX = 1200.0f;
+        auto startY = 30.0f;
+        game.collectiblePrefab.drawOnHud(raylib::Vector2{ startX, startY });
+        levelCountText.draw(game.spriteBatch, raylib::Vector2{ startX + 30.0f, startY - 20.0f }, GOLD, layer);
+    } else {
+        auto startX = 100.0f;
+        auto startY = 250.0f;
+        game.collectiblePrefab.drawOnHud(raylib::Vector2{ startX, startY });
+        levelStatsText.draw(game.spriteBatch, raylib::Vector2{ startX + 30.0f, startY - 20.0f }, GOLD, layer);
+        game.textCache.getGlyphRun(futFont, 40.0f, 1.0f, U"w poziomie", !useFuthark, false).draw(game.spriteBatch, raylib::Vector2{ startX + 140.0f, startY - 20.0f }, GOLD, layer);
+
+        startX = 930.0f;
+        startY = 250.0f;
+        game.collectiblePrefab.drawOnHud(raylib::Vector2{ startX, startY });
+        totalStatsText.draw(game.spriteBatch, raylib::Vector2{ startX + 30.0f, startY - 20.0f }, GOLD, layer);
+        game.textCache.getGlyphRun(futFont, 40.0f, 1.0f, U"w sumie", !useFuthark, false).draw(game.spriteBatch, raylib::Vector2{ startX + 140.0f, startY - 20.0f }, GOLD, layer);
+    }
+}
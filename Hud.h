@@ -0,0 +1,33 @@
+#pragma once
+
+#include "GlyphRun.h"
+
+#include "raylib-cpp.hpp"
+
+
+class Game;
+
+
+/// HUD with collectible counters. Text is laid out only when a counter or the language changes.
+class Hud {
+private:
+    Game& game;
+
+    GlyphRun levelCountText;        ///< Collected in the level, shown during the level.
+    GlyphRun levelStatsText;        ///< Collected / available in the level.
+    GlyphRun totalStatsText;        ///< Collected / available in the whole game.
+
+    // What the text currently shows.
+    int shownCollected = -1;
+    int shownAvailable = -1;
+    int shownTotalCollected = -1;
+    int shownTotalAvailable = -1;
+
+public:
+    Hud(Game& game) : game(game) {}
+
+    void draw(bool withTotals);
+
+private:
+    void update();
+};
@@ -0,0 +1,116 @@
+#include "JobSystem.h"
+
+#include "zerrors.h"
+
+#include <algorithm>
+
+
+JobSystem::JobSystem(int numWorkers) {
+#if defined(PLATFORM_WEB)
+    numWorkers = 0; // We don't build with pthreads on the Web.
+#endif
+    if (numWorkers < 0)
+        numWorkers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.emplace_back([this]() { workerLoop(); });
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quitting = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void JobSystem::parallelFor(int count, int chunkSize, const std::function<void(int, int)>& func) {
+    ZASSERT(chunkSize > 0);
+    if (count <= 0)
+        return;
+
+    auto numChunks = (count + chunkSize - 1) / chunkSize;
+    if (workers.empty() || (numChunks == 1)) {
+        for (int begin = 0; begin < count; begin += chunkSize)
+            func(begin, std::min(begin + chunkSize, count));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        jobCount = count;
+        jobChunkSize = chunkSize;
+        jobChunks = numChunks;
+        nextChunk = 0;
+        chunksDone = 0;
+        ++generation;
+    }
+    workAvailable.notify_all();
+
+    runChunks();
+
+    // Wait also for workers to leave runChunks(), so that none of them picks up chunks of the next job.
+    std::unique_lock<std::mutex> lock(mutex);
+    workFinished.wait(lock, [this]() { return (chunksDone == jobChunks) && (activeWorkers == 0); });
+    job = nullptr;
+}
+
+std::future<void> JobSystem::runAsync(std::function<void()> func) {
+    std::packaged_task<void()> task(std::move(func));
+    auto future = task.get_future();
+    if (workers.empty()) {
+        task();
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+    return future;
+}
+
+void JobSystem::runChunks() {
+    while (true) {
+        auto chunk = nextChunk++;
+        if (chunk >= jobChunks)
+            break;
+        auto begin = chunk * jobChunkSize;
+        (*job)(begin, std::min(begin + jobChunkSize, jobCount));
+        chunksDone++;
+    }
+}
+
+void JobSystem::workerLoop() {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&]() { return quitting || ((generation != seenGeneration) && (job != nullptr)) || !tasks.empty(); });
+            if (quitting)
+                return;
+            if ((generation == seenGeneration) || (job == nullptr)) {
+                // Tasks go after loops, because parallelFor() blocks the calling thread.
+                auto task = std::move(tasks.front());
+                tasks.pop_front();
+                lock.unlock();
+                task();
+                continue;
+            }
+            seenGeneration = generation;
+            ++activeWorkers;
+        }
+
+        runChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+        }
+        workFinished.notify_all();
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// Minimal thread pool for data-parallel loops, and for single tasks run in the background.
+/// Calling thread takes part in the work, so it is fine to have no workers (it is the case on the Web).
+class JobSystem {
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    uint64_t generation = 0;            ///< Incremented for every parallelFor().
+    bool quitting = false;
+    int activeWorkers = 0;              ///< Workers currently running chunks of the job.
+
+    const std::function<void(int, int)>* job = nullptr;
+    int jobCount = 0;
+    int jobChunkSize = 1;
+    int jobChunks = 0;
+    std::atomic<int> nextChunk = 0;
+    std::atomic<int> chunksDone = 0;
+
+    std::deque<std::packaged_task<void()>> tasks;   ///< Waiting for a worker. Guarded by mutex.
+
+public:
+    /// @param numWorkers   Number of worker threads. -1 for number of hardware threads minus one.
+    explicit JobSystem(int numWorkers = -1);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int getWorkerCount() const { return static_cast<int>(std::ssize(workers)); }
+
+    /// Calls func(begin, end) for consecutive chunks of [0, count), in parallel. Returns when all chunks are done.
+    void parallelFor(int count, int chunkSize, const std::function<void(int, int)>& func);
+
+    /// Runs func on a worker. Without workers it runs right away, before this returns.
+    /// @returns Future to wait for func, and to get exceptions it threw.
+    std::future<void> runAsync(std::function<void()> func);
+
+private:
+    void workerLoop();
+    void runChunks();
+};
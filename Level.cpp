@@ -3,7 +3,10 @@
 
 #include "Utilities.h"
 #include "Game.h"
+#include "LevelGenerator.h"
+#include "FileSystem.h"
 
+#include "zstr.h"
 #include "zerrors.h"
 
 #include "nlohmann/json.hpp"
@@ -14,21 +17,25 @@
 #include <numeric>
 #include <sstream>
 #include <algorithm>
+#include <random>
 
 
 void Level::load(const std::string& levelFile) {
-    exitDoorAnimation.load(game.resourceCache, "Graphics/Door/door-open-close.json"); // Here so that we can iterate on it more easily, as it reloads.
+    exitDoorAnimation.load(game.resourceCache, game.soundService, "Graphics/Door/door-open-close.json"); // Here so that we can iterate on it more easily, as it reloads.
     exitDoorAnimation.loop = false;
-    futharkAnimation.load(game.resourceCache, "Graphics/Viking/SpeechBubble.json"); // Here so that we can iterate on it more easily, as it reloads.
+    futharkAnimation.load(game.resourceCache, game.soundService, "Graphics/Viking/SpeechBubble.json"); // Here so that we can iterate on it more easily, as it reloads.
     futharkAnimation.loop = false;
 
     backgrounds.clear();
     foregrounds.clear();
+    backgroundCache.clear();
+    foregroundCache.clear();
     paralaxLayers.clear();
-    paralaxScales.clear();
-    paralaxHaxxorOffsets.clear();
     levelData.clear();
     collectibles.clear();
+    collectedCount = 0;
+    dynamicColliders.clear();
+    enemies.clear();
 
     // Custom data
     auto jsonText = loadTextFile(levelFile);
@@ -40,33 +47,74 @@ void Level::load(const std::string& levelFile) {
     extraLevelEndDelay = json["extraLevelEndDelay"].get<float>();
 
     auto musicPath = json["music"].get<std::string>();
-    auto musicVolume = json["musicVolume"].get<float>();
-    music.Load((basePath / musicPath).string());
-    music.SetVolume(musicVolume);
+    musicVolume = json["musicVolume"].get<float>();
+    endLevel(); // Previous level may have different music.
+    music = game.musicManager.get((basePath / musicPath).string()); // Most levels share music, so it usually is loaded already.
 
     for (auto item : json["backgrounds"]) {
         auto imagePath = item.get<std::string>();
-        backgrounds.emplace_back((basePath / imagePath).string());
+        backgrounds.emplace_back(loadImageFile((basePath / imagePath).string()));
     }
 
     for (auto item : json["foregrounds"]) {
         auto imagePath = item.get<std::string>();
-        foregrounds.emplace_back((basePath / imagePath).string());
+        foregrounds.emplace_back(loadImageFile((basePath / imagePath).string()));
     }
 
     for (auto layer : json["paralaxLayers"]) {
         auto imagePath = layer["image"].get<std::string>();
         auto scaleX = layer["scale"]["x"].get<float>();
         auto scaleY = layer["scale"]["y"].get<float>();
-        paralaxHaxxorOffsets.push_back(layer["paralaxHaxxorOffset"].get<float>());
+        raylib::Vector2 offset = { 0.0f, 0.0f };
+        if (layer.contains("offset"))
+            offset = raylib::Vector2{ layer["offset"]["x"].get<float>(), layer["offset"]["y"].get<float>() };
 
-        paralaxLayers.emplace_back((basePath / imagePath).string());
-        paralaxLayers.back().SetWrap(TEXTURE_WRAP_REPEAT); // For this to work textures must have power of 2 dimensions.
-        paralaxScales.emplace_back(scaleX, scaleY);
+        paralaxLayers.push_back(ParallaxLayer{ raylib::Texture2D(loadImageFile((basePath / imagePath).string())), raylib::Vector2{ scaleX, scaleY }, offset });
+        paralaxLayers.back().texture.SetWrap(TEXTURE_WRAP_REPEAT); // For this to work textures must have power of 2 dimensions.
     }
 
-    // LDtk data
-    auto ldtkDir = basePath / json["ldtkMap"].get<std::string>();
+    if (json.contains("generator")) {
+        loadGenerated(game.levelGenerator.generateForLevel(levelFile, json["generator"], tileSize));
+    }
+    else {
+        loadLdtk(basePath / json["ldtkMap"].get<std::string>());
+    }
+
+    if (json.contains("randomEnemies")) {
+        const auto& randomEnemies = json["randomEnemies"];
+        auto seed = randomEnemies["seed"].get<uint32_t>();
+        enemies.spawnRandom(EnemyType::PATROL, randomEnemies["patrol"].get<int>(), seed);
+        enemies.spawnRandom(EnemyType::JUMPER, randomEnemies["jumper"].get<int>(), seed + 1);
+        enemies.spawnRandom(EnemyType::FLYER, randomEnemies["flyer"].get<int>(), seed + 2);
+    }
+
+    if (json.contains("stressColliders"))
+        addStressColliders(json["stressColliders"].get<int>());
+    if (json.contains("stressCollectibles"))
+        addStressCollectibles(json["stressCollectibles"].get<int>());
+
+    stressReportFrames = json.value("stressReportFrames", 0);
+    stressFrames = 0;
+    stressColliderTime = 0.0;
+    stressEnemyTime = 0.0;
+    stressFrameTime = 0.0;
+    stressCollectibleTime = 0.0;
+    stressCollectiblesDrawn = 0;
+    stressColliderTests = 0;
+
+    // Backgrounds and foregrounds never change during the level, so they are cached. Load can happen while drawing, so not yet.
+    staticLayerCachesBuilt = false;
+}
+
+void Level::buildStaticLayerCaches() {
+    if (staticLayerCachesBuilt)
+        return;
+    backgroundCache.build(backgrounds, levelWidth, levelHeight);
+    foregroundCache.build(foregrounds, levelWidth, levelHeight);
+    staticLayerCachesBuilt = true;
+}
+
+void Level::loadLdtk(const std::filesystem::path& ldtkDir) {
     auto ldtkDataText = loadTextFile((ldtkDir / "data.json").string());
     auto ldtkData = nlohmann::json::parse(ldtkDataText);
 
@@ -82,10 +130,18 @@ void Level::load(const std::string& levelFile) {
     furharkTrigger = loadJsonRect(ldtkData["entities"]["FurharkTrigger"][0]);
 
     for (const auto& collectible : ldtkData["entities"]["Collectible"]) {
-        collectibles.emplace_back(game.collectiblePrefab);
-        collectibles.back().position = loadJsonRect(collectible).GetPosition();
+        collectibles.push_back(Collectible{ loadJsonRect(collectible).GetPosition() });
     }
 
+    if (ldtkData["entities"].contains("MovingPlatform")) {
+        for (const auto& movingPlatform : ldtkData["entities"]["MovingPlatform"]) {
+            dynamicColliders.emplace_back();
+            dynamicColliders.back().load(movingPlatform, tileSize);
+        }
+    }
+
+    enemies.loadFromLdtk(ldtkData["entities"]);
+
     // IntGrid
     auto intGridText = loadTextFile((ldtkDir / "IntGrid.csv").string());
     std::stringstream intGridStream(intGridText);
@@ -102,9 +158,53 @@ void Level::load(const std::string& levelFile) {
     }
 }
 
+void Level::loadGenerated(const GeneratedLevel& generatedLevel) {
+    setLevelData(generatedLevel.tileSize, generatedLevel.levelWidth, generatedLevel.levelHeight, generatedLevel.levelData);
+
+    playerStartPosition = generatedLevel.playerStartPosition;
+    levelExit = generatedLevel.levelExit;
+    levelExitDoor = generatedLevel.levelExitDoor;
+    furharkBubble = raylib::Rectangle{ 0.0f, 0.0f, 0.0f, 0.0f };
+    furharkTrigger = raylib::Rectangle{ 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for (const auto& position : generatedLevel.collectibles) {
+        collectibles.push_back(Collectible{ position });
+    }
+
+    // There are no LDtk layer images, so draw tiles into a background image.
+    auto widthTiles = levelWidth / tileSize;
+    auto heightTiles = levelHeight / tileSize;
+    raylib::Image image(levelWidth, levelHeight, BLANK);
+    for (int y = 0; y < heightTiles; ++y) {
+        for (int x = 0; x < widthTiles; ++x) {
+            raylib::Rectangle tileRect { static_cast<float>(x * tileSize), static_cast<float>(y * tileSize), static_cast<float>(tileSize), static_cast<float>(tileSize) };
+            auto tile = getTileRaw(x, y).value_or(TileType::EMPTY);
+            if (tile == TileType::WALL) {
+                image.DrawRectangle(tileRect, DARKBROWN);
+                if (!isCollider(getTileRaw(x, y - 1).value_or(TileType::EMPTY)))
+                    image.DrawRectangle(raylib::Rectangle{ tileRect.x, tileRect.y, tileRect.width, tileSize / 4.0f }, DARKGREEN);
+            }
+            else
+            if (tile == TileType::LAVA) {
+                image.DrawRectangle(tileRect, ORANGE);
+            }
+        }
+    }
+    backgrounds.emplace_back(image);
+}
+
+void Level::setLevelData(int tileSize, int levelWidth, int levelHeight, std::vector<int8_t> levelData) {
+    ZASSERT(levelWidth % tileSize == 0);
+    ZASSERT(levelHeight % tileSize == 0);
+    ZASSERT(std::ssize(levelData) == (levelWidth / tileSize) * (levelHeight / tileSize));
+    this->tileSize = tileSize;
+    this->levelWidth = levelWidth;
+    this->levelHeight = levelHeight;
+    this->levelData = std::move(levelData);
+}
+
 void Level::startLevel() {
-    music.Seek(0);
-    music.Play();
+    game.musicManager.play(music, musicVolume);
     game.player.setInitialState(playerStartPosition);
 
     showFuthark = false;
@@ -113,25 +213,58 @@ void Level::startLevel() {
     levelEnding = false;
     levelEndingStartTime = 0.0f;
     levelEndingByDeath = false;
+
+    exitDoorPlayer = AnimationPlayer();
+    futharkPlayer = AnimationPlayer();
+
+    dynamicColliderGrid.resize(levelWidth, levelHeight, 128.0f);
+    dynamicColliderBounds.clear();
+    for (const auto& collider : dynamicColliders)
+        dynamicColliderBounds.push_back(collider.rect);
+    dynamicColliderGrid.build(dynamicColliderBounds);
+
+    triggers.clear();
+    triggers.push_back(LevelTrigger{ levelExit, TriggerType::EXIT });
+    if ((furharkTrigger.width > 0.0f) && (furharkTrigger.height > 0.0f))
+        triggers.push_back(LevelTrigger{ furharkTrigger, TriggerType::FUTHARK });
+
+    buildEntityGrid();
+}
+
+void Level::buildEntityGrid() {
+    // Collectibles and triggers don't move, so we build the grid only when they are added.
+    entityBounds.clear();
+    for (const auto& collectible : collectibles)
+        entityBounds.push_back(game.collectiblePrefab.hitboxAt(collectible.position));
+    for (const auto& trigger : triggers)
+        entityBounds.push_back(trigger.rect);
+    entityGrid.resize(levelWidth, levelHeight, 256.0f);
+    entityGrid.build(entityBounds);
 }
 
 void Level::endLevel() {
-    music.Stop();
+    if (music != invalidResourceId)
+        game.musicManager.stop(music);
 }
 
 void Level::drawBackground() {
-    for (int i = 0; i < std::ssize(paralaxLayers); ++i) {
-        auto pos = game.cameraPosition * paralaxScales[i];
-        pos.y += paralaxHaxxorOffsets[i];
-        //auto pos = raylib::Vector2::Zero();
-        //paralaxLayers[i].Draw(game.worldToScreen(pos));
-        //game.drawSprite(pos, paralaxLayers[i], raylib::Vector2::Zero(), false);
-        //paralaxLayers[i].Draw(raylib::Rectangle {pos.x, pos.y, game.screenWidth * 1.0f, game.screenHeight * 1.0f}, raylib::Rectangle {0, 0, game.screenWidth * 1.0f, game.screenHeight * 1.0f});
-        DrawTextureTiled(paralaxLayers[i], raylib::Rectangle {pos.x, pos.y, game.screenWidth * 1.0f, game.screenHeight * 1.0f}, raylib::Rectangle {0, 0, game.screenWidth * 1.0f, game.screenHeight * 1.0f});
+    // One screen-sized quad per layer. Texture wraps, so UVs outside of 0-1 repeat it.
+    for (const auto& layer : paralaxLayers) {
+        auto pos = game.cameraPosition * layer.scale + layer.offset;
+        // Keep UVs small, so they don't lose precision far from the origin.
+        auto [repeatsX, u] = divide(pos.x, static_cast<float>(layer.texture.width));
+        auto [repeatsY, v] = divide(pos.y, static_cast<float>(layer.texture.height));
+        layer.texture.Draw(raylib::Rectangle { u, v, game.screenWidth * 1.0f, game.screenHeight * 1.0f }, raylib::Rectangle { 0.0f, 0.0f, game.screenWidth * 1.0f, game.screenHeight * 1.0f });
     }
 
-    for (int i = 0; i < std::ssize(backgrounds); ++i) {
-        backgrounds[i].Draw(game.worldToScreen({ 0.0f, 0.0f }));
+    drawStaticLayers(backgroundCache, backgrounds);
+
+    for (const auto& collider : dynamicColliders) {
+        if (game.cull(collider.rect))
+            continue;
+        auto screenPosition = game.worldToScreen(collider.rect.GetPosition());
+        DrawRectangle(screenPosition.x, screenPosition.y, collider.rect.width, collider.rect.height, DARKBROWN);
+        DrawRectangle(screenPosition.x, screenPosition.y, collider.rect.width, tileSize / 4, DARKGREEN);
     }
 
     if (levelEnding && !levelEndingByDeath) {
@@ -140,10 +273,13 @@ void Level::drawBackground() {
             // Hack
             game.player.playerHide = true;
         }
-        auto [origin, image, sound] = exitDoorAnimation.spriteForTime(animTime);
-        if (sound)
-            sound->Play();
-        game.drawSprite(levelExitDoor.GetPosition(), image, origin, false);
+        if (!game.cull(exitDoorAnimation.getBounds(levelExitDoor.GetPosition()))) {
+            exitDoorPlayer.play(exitDoorAnimation);
+            exitDoorPlayer.seek(animTime);
+            if (auto sound = exitDoorPlayer.takeSound(); sound != noSound)
+                game.soundService.play(sound, levelExitDoor.GetPosition());
+            game.drawSprite(levelExitDoor.GetPosition(), exitDoorPlayer.getSprite(), exitDoorPlayer.getOrigin(), false, SpriteLayer::PROPS);
+        }
     }
 
     if (showFuthark) {
@@ -151,21 +287,157 @@ void Level::drawBackground() {
         if (animTime >= futharkAnimation.getAnimationLength()) {
             animTime = futharkAnimation.getAnimationLength() - 0.01f;
         }
-        auto [origin, image, sound] = futharkAnimation.spriteForTime(animTime);
-        if (sound)
-            sound->Play();
-        game.drawSprite(furharkBubble.GetPosition(), image, origin, false);
+        if (!game.cull(futharkAnimation.getBounds(furharkBubble.GetPosition()))) {
+            futharkPlayer.play(futharkAnimation);
+            futharkPlayer.seek(animTime);
+            if (auto sound = futharkPlayer.takeSound(); sound != noSound)
+                game.soundService.play(sound, furharkBubble.GetPosition());
+            game.drawSprite(furharkBubble.GetPosition(), futharkPlayer.getSprite(), futharkPlayer.getOrigin(), false, SpriteLayer::PROPS);
+        }
+    }
+}
+
+void Level::drawStaticLayers(const StaticLayerCache& cache, const std::vector<raylib::Texture2D>& layers) {
+    auto screenOrigin = game.worldToScreen({ 0.0f, 0.0f });
+
+    if (useStaticLayerCache && staticLayerCachesBuilt) {
+        auto drawn = cache.draw(screenOrigin, game.getCameraView());
+        game.countDraws(drawn, cache.getTileCount() - drawn);
+        return;
+    }
+
+    for (const auto& layer : layers) {
+        if (game.cull(raylib::Rectangle{ raylib::Vector2::Zero(), layer.GetSize() }))
+            continue;
+        layer.Draw(screenOrigin);
     }
 }
 
 void Level::update() {
-    for (int i = 0; i < std::ssize(foregrounds); ++i) {
-        foregrounds[i].Draw(game.worldToScreen({ 0.0f, 0.0f }));
+    game.flushSprites(); // Player and props are below enemies and foregrounds.
+    enemies.draw();
+
+    drawStaticLayers(foregroundCache, foregrounds);
+
+    auto startTime = GetTime();
+    collectiblesDrawn = 0;
+
+    // Grid only gives us collectibles near the camera. Ones in cells that are off screen aren't even visited.
+    auto numCollectibles = std::ssize(collectibles);
+    entityGrid.query(game.getCameraView(), [&](int index) {
+        if ((index >= numCollectibles) || collectibles[index].collected)
+            return;
+        if (game.cull(game.collectiblePrefab.drawBoundsAt(collectibles[index].position)))
+            return;
+        game.collectiblePrefab.draw(collectibles[index]);
+        ++collectiblesDrawn;
+    });
+
+    game.flushSprites();
+    collectiblesTime = static_cast<float>(GetTime() - startTime);
+}
+
+void Level::updateTriggers() {
+    auto& player = game.player;
+    auto numCollectibles = std::ssize(collectibles);
+
+    entityGrid.query(raylib::Rectangle{ player.position, raylib::Vector2::Zero() }, [&](int index) {
+        if (index < numCollectibles) {
+            if (game.collectiblePrefab.tryCollect(collectibles[index], player.position))
+                ++collectedCount;
+            return;
+        }
+
+        const auto& trigger = triggers[index - numCollectibles];
+        if (!trigger.rect.CheckCollision(player.position))
+            return;
+
+        switch (trigger.type) {
+            case TriggerType::EXIT:
+                game.endLevelByDeath = false;
+                setLevelEnding(false);
+                player.setPlayerDead(false);
+                break;
+            case TriggerType::FUTHARK:
+                setShowFuthark();
+                break;
+        }
+    });
+
+    // Lava is a tile, so we just look it up.
+    if (player.state == PlayerState::GROUNDED) {
+        auto playerTile = getTileWorld(player.position + raylib::Vector2(0, tileSize / 2.0f)).value_or(TileType::EMPTY);
+        if (playerTile == TileType::LAVA) {
+            game.endLevelByDeath = true;
+            setLevelEnding(true);
+            player.setPlayerDead(true);
+        }
     }
+}
 
-    for (auto& collectible : collectibles) {
-        collectible.update();
+void Level::updateDynamicColliders() {
+    auto startTime = GetTime();
+
+    dynamicColliderTests = 0;
+    dynamicColliderBounds.resize(dynamicColliders.size());
+    for (int i = 0; i < std::ssize(dynamicColliders); ++i) {
+        dynamicColliders[i].update(game.levelTimeDelta);
+        dynamicColliderBounds[i] = dynamicColliders[i].rect;
     }
+    dynamicColliderGrid.build(dynamicColliderBounds);
+
+    dynamicCollidersTime = static_cast<float>(GetTime() - startTime);
+}
+
+void Level::addStressColliders(int count) {
+    std::mt19937 rng(static_cast<uint32_t>(dynamicColliders.size()));
+    std::uniform_real_distribution<float> xDistribution(0.0f, static_cast<float>(levelWidth - 4 * tileSize));
+    std::uniform_real_distribution<float> yDistribution(0.0f, static_cast<float>(levelHeight - tileSize));
+    std::uniform_real_distribution<float> offsetDistribution(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> speedDistribution(20.0f, 120.0f);
+
+    for (int i = 0; i < count; ++i) {
+        raylib::Rectangle startRect { xDistribution(rng), yDistribution(rng), 4.0f * tileSize, static_cast<float>(tileSize) };
+        auto endPosition = startRect.GetPosition() + ((i % 2 == 0) ? raylib::Vector2{ offsetDistribution(rng), 0.0f } : raylib::Vector2{ 0.0f, offsetDistribution(rng) });
+        dynamicColliders.emplace_back();
+        dynamicColliders.back().setPath(startRect, { startRect.GetPosition(), endPosition }, speedDistribution(rng), true);
+    }
+
+    TraceLog(LOG_INFO, (ZSTR() << "Dynamic colliders: " << std::ssize(dynamicColliders)).str().c_str());
+}
+
+void Level::updateStressReport() {
+    if (stressFrames >= stressReportFrames)
+        return;
+
+    ++stressFrames;
+    stressColliderTime += dynamicCollidersTime;
+    stressEnemyTime += enemies.updateTime;
+    stressFrameTime += game.window.GetFrameTime();
+    stressColliderTests += dynamicColliderTests;
+    stressCollectibleTime += collectiblesTime;
+    stressCollectiblesDrawn += collectiblesDrawn;
+    if (stressFrames < stressReportFrames)
+        return;
+
+    TraceLog(LOG_INFO, (ZSTR() << "Stress report over " << stressFrames << " frames: "
+        << getDynamicColliderCount() << " colliders " << stressColliderTime * 1000.0 / stressFrames << " ms (" << stressColliderTests / stressFrames << " narrowphase tests), "
+        << enemies.getEnemyCount() << " enemies " << stressEnemyTime * 1000.0 / stressFrames << " ms (" << game.jobSystem.getWorkerCount() << " workers), "
+        << std::get<1>(getCollectibleStats()) << " collectibles " << stressCollectibleTime * 1000.0 / stressFrames << " ms (" << stressCollectiblesDrawn / stressFrames << " drawn), "
+        << "frame " << stressFrameTime * 1000.0 / stressFrames << " ms").str().c_str());
+}
+
+void Level::addStressCollectibles(int count) {
+    std::mt19937 rng(static_cast<uint32_t>(collectibles.size()));
+    std::uniform_real_distribution<float> xDistribution(0.0f, static_cast<float>(levelWidth));
+    std::uniform_real_distribution<float> yDistribution(0.0f, static_cast<float>(levelHeight));
+
+    for (int i = 0; i < count; ++i)
+        collectibles.push_back(Collectible{ raylib::Vector2{ xDistribution(rng), yDistribution(rng) } });
+
+    buildEntityGrid();
+
+    TraceLog(LOG_INFO, (ZSTR() << "Collectibles: " << std::ssize(collectibles)).str().c_str());
 }
 
 std::optional<TileType> Level::getTileRaw(int x, int y) const {
@@ -184,11 +456,83 @@ std::optional<TileType> Level::getTileWorld(raylib::Vector2 worldPosition) const
     return getTileRaw(static_cast<int>(worldPosition.x) / tileSize, static_cast<int>(worldPosition.y) / tileSize);
 }
 
+/// Performs collision detection against tiles and dynamic colliders.
+/// Dynamic colliders only add to the flags. Use dynamicColliderResponse() to move out of them.
+/// returns (grounded, touchingCeiling, touchingWall, touchingWallDirection, moveDelta)
+std::tuple<bool, bool, bool, int, raylib::Vector2> Level::collisionDetection(raylib::Rectangle hitBox, raylib::Vector2 velocity) {
+    bool grounded;
+    bool touchingCeiling;
+    bool touchingWall;
+    int touchingWallDirection;
+    raylib::Vector2 moveDelta;
+    std::tie(grounded, touchingCeiling, touchingWall, touchingWallDirection, moveDelta) = tileCollisionDetection(hitBox, velocity);
+
+    // Grow by a pixel, so that we detect touching, not only overlapping.
+    raylib::Rectangle probe { hitBox.x - 1.0f, hitBox.y - 1.0f, hitBox.width + 2.0f, hitBox.height + 2.0f };
+    dynamicColliderGrid.query(probe, [&](int index) {
+        dynamicColliderTests++;
+        const auto& rect = dynamicColliders[index].rect;
+        auto overlapX = std::min(hitBox.x + hitBox.width, rect.x + rect.width) - std::max(hitBox.x, rect.x);
+        auto overlapY = std::min(hitBox.y + hitBox.height, rect.y + rect.height) - std::max(hitBox.y, rect.y);
+        if ((overlapX < -1.0f) || (overlapY < -1.0f) || ((overlapX <= 0.0f) && (overlapY <= 0.0f)))
+            return;
+
+        if (overlapX > overlapY) {
+            if (hitBox.y + hitBox.height / 2 < rect.y + rect.height / 2)
+                grounded = true;
+            else
+                touchingCeiling = true;
+        }
+        else {
+            touchingWall = true;
+            touchingWallDirection = (hitBox.x + hitBox.width / 2 < rect.x + rect.width / 2) ? 1 : -1;
+        }
+    });
+
+    return { grounded, touchingCeiling, touchingWall, touchingWallDirection, moveDelta };
+}
+
+std::tuple<raylib::Vector2, raylib::Vector2> Level::dynamicColliderResponse(raylib::Rectangle hitBox) {
+    raylib::Vector2 pushOut = raylib::Vector2::Zero();
+    raylib::Vector2 carryVelocity = raylib::Vector2::Zero();
+
+    raylib::Rectangle probe { hitBox.x - 1.0f, hitBox.y - 1.0f, hitBox.width + 2.0f, hitBox.height + 2.0f };
+    dynamicColliderGrid.query(probe, [&](int index) {
+        dynamicColliderTests++;
+        const auto& collider = dynamicColliders[index];
+        const auto& rect = collider.rect;
+        auto overlapX = std::min(hitBox.x + hitBox.width, rect.x + rect.width) - std::max(hitBox.x, rect.x);
+        auto overlapY = std::min(hitBox.y + hitBox.height, rect.y + rect.height) - std::max(hitBox.y, rect.y);
+        if ((overlapX <= 0.0f) || (overlapY < -1.0f))
+            return;
+
+        auto above = hitBox.y + hitBox.height / 2 < rect.y + rect.height / 2;
+        if (above && (overlapY <= overlapX)) {
+            carryVelocity = collider.velocity;
+        }
+
+        if (overlapY <= 0.0f)
+            return;
+
+        // Push out along the axis of smaller penetration.
+        if (overlapX < overlapY) {
+            auto push = (hitBox.x + hitBox.width / 2 < rect.x + rect.width / 2) ? -overlapX : overlapX;
+            if (std::fabs(push) > std::fabs(pushOut.x)) pushOut.x = push;
+        }
+        else {
+            auto push = above ? -overlapY : overlapY;
+            if (std::fabs(push) > std::fabs(pushOut.y)) pushOut.y = push;
+        }
+    });
+
+    return { pushOut, carryVelocity };
+}
+
 /// Performs collision detection and response.
 /// @note assumes hitBoxes are smaller than a tile.
 /// @note Implementation is weak, and also assumes that colliders don't touch with just corners.
 /// returns (grounded, touchingCeiling, touchingWall, touchingWallDirection, moveDelta)
-std::tuple<bool, bool, bool, int, raylib::Vector2> Level::collisionDetection(raylib::Rectangle hitBox, raylib::Vector2 velocity) {
+std::tuple<bool, bool, bool, int, raylib::Vector2> Level::tileCollisionDetection(raylib::Rectangle hitBox, raylib::Vector2 velocity) {
     ZASSERT(hitBox.GetWidth() < tileSize);
     ZASSERT(hitBox.GetHeight() < tileSize);
 
@@ -342,13 +686,7 @@ std::tuple<bool, bool, bool, int, raylib::Vector2> Level::collisionDetection(ray
 }
 
 std::tuple<int, int> Level::getCollectibleStats() const {
-    int collectedCount = 0;
-    int totalCount = 0;
-    for (auto& collectible : collectibles) {
-        if (collectible.collected) collectedCount++;
-        if (!collectible.forHud) totalCount++;
-    }
-    return { collectedCount, totalCount };
+    return { collectedCount, static_cast<int>(std::ssize(collectibles)) };
 }
 
 void Level::setShowFuthark() {
@@ -1,18 +1,25 @@
 #pragma once
 
 #include "Collectible.h"
+#include "DynamicCollider.h"
+#include "EnemySystem.h"
+#include "StaticLayerCache.h"
+#include "UniformGrid.h"
+#include "PathInterner.h"
 
 #include "zerrors.h"
 
 #include "raylib-cpp.hpp"
 
 #include <vector>
+#include <filesystem>
 #include <cstdint>
 #include <optional>
 #include <tuple>
 
 
 class Game;
+struct GeneratedLevel;
 
 enum class TileType {
     EMPTY = 0,
@@ -21,6 +28,24 @@ enum class TileType {
     INVISIBLE_WALL = 3,
 };
 
+enum class TriggerType {
+    EXIT,
+    FUTHARK,
+};
+
+/// Area that does something when player enters it.
+struct LevelTrigger {
+    raylib::Rectangle rect;
+    TriggerType type;
+};
+
+/// Background image that scrolls slower than the level, and repeats in both directions.
+struct ParallaxLayer {
+    raylib::Texture2D texture;  ///< Must have power of 2 dimensions, for wrapping to work.
+    raylib::Vector2 scale;      ///< How fast layer scrolls compared to the camera.
+    raylib::Vector2 offset;     ///< Added to scrolled position (in texture pixels).
+};
+
 inline bool isCollider(TileType tile) {
     switch (tile) {
         case TileType::EMPTY: return false;
@@ -36,7 +61,8 @@ private:
     Game& game;
 
 public:
-    raylib::Music music;
+    ResourceId music = invalidResourceId;  ///< In Game::musicManager.
+    float musicVolume = 1.0f;
 
 public:
     int tileSize = 16;      ///< Tiles are squares of this size.
@@ -47,12 +73,21 @@ public:
 private:
     std::vector<raylib::Texture2D> backgrounds; ///< Level images drawn before entities.
     std::vector<raylib::Texture2D> foregrounds; ///< Level images drawn after entities.
-    std::vector<raylib::Texture2D> paralaxLayers;
-    std::vector<raylib::Vector2> paralaxScales;
+    std::vector<ParallaxLayer> paralaxLayers;
+    StaticLayerCache backgroundCache;           ///< backgrounds composited together.
+    StaticLayerCache foregroundCache;           ///< foregrounds composited together.
+    bool staticLayerCachesBuilt = false;        ///< False until buildStaticLayerCaches() is called after load().
     std::vector<int8_t> levelData; ///< Level data, where top-left tile is first, bottom-right is last.
-    std::vector<float> paralaxHaxxorOffsets; ///< Add to paralax y, cause no time to fix...
 
     std::vector<Collectible> collectibles;
+    int collectedCount = 0;                         ///< Number of collectibles with collected set.
+    std::vector<LevelTrigger> triggers;
+    std::vector<raylib::Rectangle> entityBounds;    ///< Bounds of collectibles, then triggers, for entityGrid.
+    UniformGrid entityGrid;                         ///< Broadphase for collectibles and triggers. Item index is index in entityBounds.
+
+    std::vector<DynamicCollider> dynamicColliders;
+    std::vector<raylib::Rectangle> dynamicColliderBounds;   ///< Bounds of dynamicColliders, for dynamicColliderGrid.
+    UniformGrid dynamicColliderGrid;                        ///< Broadphase for dynamicColliders.
 
 public:
     raylib::Vector2 playerStartPosition = { 0.0f, 0.0f };
@@ -67,13 +102,34 @@ public:
     float levelEndingStartTime = 0.0f;  ///< When level ending started.
     float extraLevelEndDelay = 0.0f;
     bool levelEndingByDeath = false;
-    Animation exitDoorAnimation;
-    Animation futharkAnimation;
+
+    int dynamicColliderTests = 0;       ///< Number of narrowphase tests against dynamic colliders during last frame.
+    float dynamicCollidersTime = 0.0f;  ///< Time of dynamic colliders update during last frame (in seconds).
+    bool useStaticLayerCache = true;    ///< If false backgrounds and foregrounds are drawn one by one. For comparing performance.
+    int collectiblesDrawn = 0;          ///< Number of collectibles drawn during last frame.
+    float collectiblesTime = 0.0f;      ///< Time of drawing collectibles during last frame (in seconds).
+
+    int stressReportFrames = 0;         ///< Stress levels log averages of these stats over this many frames. Zero for no report.
+    int stressFrames = 0;               ///< Frames summed so far.
+    double stressColliderTime = 0.0;
+    double stressEnemyTime = 0.0;
+    double stressFrameTime = 0.0;
+    double stressCollectibleTime = 0.0;
+    int64_t stressCollectiblesDrawn = 0;
+    int64_t stressColliderTests = 0;
+    AnimationClip exitDoorAnimation;
+    AnimationClip futharkAnimation;
+    AnimationPlayer exitDoorPlayer;
+    AnimationPlayer futharkPlayer;
+    EnemySystem enemies;
 
 public:
-    Level(Game& game) : game(game) {}
+    Level(Game& game) : game(game), enemies(game, *this) {}
 
     void load(const std::string& levelFile);
+    void loadLdtk(const std::filesystem::path& ldtkDir);
+    void loadGenerated(const GeneratedLevel& generatedLevel);
+    void setLevelData(int tileSize, int levelWidth, int levelHeight, std::vector<int8_t> levelData);
 
     void startLevel();
     void setShowFuthark();
@@ -82,14 +138,41 @@ public:
     bool hasLevelEnded() const;
     void endLevel();
 
+    /// Builds caches of backgrounds and foregrounds, if level was loaded since last call.
+    /// Must be called outside of BeginDrawing() and EndDrawing(). Until then layers are drawn directly.
+    void buildStaticLayerCaches();
+
     void drawBackground();
     void update();
 
+    /// Collects collectibles and fires triggers (exit, Futhark, lava) that player touches.
+    void updateTriggers();
+    void updateDynamicColliders();
+
+    /// Adds randomly moving colliders. For stress testing.
+    void addStressColliders(int count);
+
+    /// Sums stats of the frame, and logs their averages once stressReportFrames were summed.
+    void updateStressReport();
+    int getDynamicColliderCount() const { return static_cast<int>(std::ssize(dynamicColliders)); }
+
+    /// Adds collectibles at random positions. For stress testing.
+    void addStressCollectibles(int count);
+
     std::optional<TileType> getTileRaw(int x, int y) const;
     std::optional<TileType> getTileWorld(raylib::Vector2 worldPosition) const;
 
     std::tuple<bool, bool, bool, int, raylib::Vector2> collisionDetection(raylib::Rectangle hitBox, raylib::Vector2 velocity);
 
+    /// Response to dynamic colliders.
+    /// @returns (pushOut, carryVelocity) - how to move hitBox out of colliders, and velocity of the collider hitBox stands on.
+    std::tuple<raylib::Vector2, raylib::Vector2> dynamicColliderResponse(raylib::Rectangle hitBox);
+
     /// @returns [ collectedCount, totalCount ]
     std::tuple<int, int> getCollectibleStats() const;
+
+private:
+    void buildEntityGrid();
+    void drawStaticLayers(const StaticLayerCache& cache, const std::vector<raylib::Texture2D>& layers);
+    std::tuple<bool, bool, bool, int, raylib::Vector2> tileCollisionDetection(raylib::Rectangle hitBox, raylib::Vector2 velocity);
 };
@@ -0,0 +1,340 @@
+#include "LevelGenerator.h"
+
+#include "Game.h"
+#include "Utilities.h"
+
+#include "zstr.h"
+#include "zerrors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+
+namespace {
+
+/// @returns Random integer in [minValue, maxValue].
+/// @note We don't use std::uniform_int_distribution, because it gives different results on different compilers.
+int randomInt(std::mt19937& rng, int minValue, int maxValue) {
+    if (maxValue <= minValue)
+        return minValue;
+    return minValue + static_cast<int>(rng() % static_cast<uint32_t>(maxValue - minValue + 1));
+}
+
+/// @returns Random float in [0, 1).
+float randomFloat(std::mt19937& rng) {
+    return static_cast<float>(rng() >> 8) / 16777216.0f;
+}
+
+} // namespace
+
+
+DifficultyProfile DifficultyProfile::fromJson(const nlohmann::json& json) {
+    DifficultyProfile profile;
+    profile.levelWidth = json["levelWidth"].get<int>();
+    profile.levelHeight = json["levelHeight"].get<int>();
+    profile.minPlatformLength = json["minPlatformLength"].get<int>();
+    profile.maxPlatformLength = json["maxPlatformLength"].get<int>();
+    profile.minGap = json["minGap"].get<int>();
+    profile.maxGap = json["maxGap"].get<int>();
+    profile.maxStepUp = json["maxStepUp"].get<int>();
+    profile.maxStepDown = json["maxStepDown"].get<int>();
+    profile.floatingPlatformChance = json["floatingPlatformChance"].get<float>();
+    profile.collectibleCount = json["collectibleCount"].get<int>();
+    profile.maxAttempts = json["maxAttempts"].get<int>();
+
+    ZASSERT(profile.levelHeight >= 30) << "Generated level must be at least 30 tiles high.";
+    ZASSERT(profile.minPlatformLength >= 3);
+    ZASSERT(profile.minPlatformLength <= profile.maxPlatformLength);
+    ZASSERT(profile.minGap >= 1);
+    ZASSERT(profile.minGap <= profile.maxGap);
+    ZASSERT(profile.levelWidth >= 4 * (profile.maxPlatformLength + profile.maxGap)) << "Generated level is too narrow for its platforms.";
+    return profile;
+}
+
+
+LevelGenerator::LevelGenerator(Game& game)
+    : game(game)
+    , scratchLevel(game)
+{
+}
+
+LevelGenerator::~LevelGenerator() {
+    waitForPregeneration(); // Task uses this.
+}
+
+GeneratedLevel LevelGenerator::generateForLevel(const std::string& levelFile, const nlohmann::json& generatorJson, int tileSize) {
+    waitForPregeneration();
+    if (!pregeneratedFile.empty() && (pregeneratedFile == levelFile)) {
+        pregeneratedFile.clear();
+        return std::move(pregenerated);
+    }
+
+    auto seed = generatorJson["seed"].get<uint32_t>();
+    auto profile = DifficultyProfile::fromJson(generatorJson["difficulty"]);
+    return generate(seed, profile, tileSize);
+}
+
+void LevelGenerator::pregenerate(const std::string& levelFile) {
+    waitForPregeneration();
+    pregeneratedFile.clear();
+    pregeneration = game.jobSystem.runAsync([this, levelFile, player = copyPlayer()]() {
+        auto jsonText = loadTextFile(levelFile);
+        auto json = nlohmann::json::parse(jsonText);
+        if (!json.contains("generator"))
+            return;
+
+        auto seed = json["generator"]["seed"].get<uint32_t>();
+        auto profile = DifficultyProfile::fromJson(json["generator"]["difficulty"]);
+        pregenerated = generate(seed, profile, json["tileSize"].get<int>(), player);
+        pregeneratedFile = levelFile;
+    });
+}
+
+void LevelGenerator::waitForPregeneration() {
+    if (!pregeneration.valid())
+        return;
+    auto future = std::move(pregeneration);
+    try {
+        future.get();
+    }
+    catch (const std::exception& exc) {
+        // Level::load will generate it again, and report the error.
+        TraceLog(LOG_WARNING, (ZSTR() << "Level pregeneration failed: " << exc.what()).str().c_str());
+    }
+}
+
+LevelGenerator::PlayerModel LevelGenerator::copyPlayer() const {
+    auto [origin, image, sound] = game.player.runAnimation.spriteForTime(0.0f);
+    return { game.player.physics, origin };
+}
+
+GeneratedLevel LevelGenerator::generate(uint32_t seed, const DifficultyProfile& profile, int tileSize) {
+    return generate(seed, profile, tileSize, copyPlayer());
+}
+
+GeneratedLevel LevelGenerator::generate(uint32_t seed, const DifficultyProfile& profile, int tileSize, const PlayerModel& player) {
+    auto startTime = GetTime();
+
+    std::mt19937 rng(seed);
+    GeneratedLevel level;
+    level.tileSize = tileSize;
+    level.levelWidth = profile.levelWidth * tileSize;
+    level.levelHeight = profile.levelHeight * tileSize;
+
+    for (level.attempts = 1; level.attempts <= profile.maxAttempts; ++level.attempts) {
+        buildCandidate(rng, profile, level);
+
+        scratchLevel.setLevelData(tileSize, level.levelWidth, level.levelHeight, level.levelData);
+        findPlatforms(level);
+        auto reachable = findReachablePlatforms(level, player);
+
+        auto exitPlatform = platformAt(static_cast<int>(level.levelExitDoor.x) / tileSize, static_cast<int>(level.levelExitDoor.y) / tileSize);
+        ZASSERT(exitPlatform >= 0);
+        if (!reachable[exitPlatform])
+            continue;
+
+        // Place collectibles on reachable platforms only.
+        std::vector<int> reachableCells;
+        auto widthTiles = profile.levelWidth;
+        for (int i = 0; i < std::ssize(platforms); ++i) {
+            if (!reachable[i]) continue;
+            for (int x = platforms[i].x0; x <= platforms[i].x1; ++x)
+                reachableCells.push_back(platforms[i].y * widthTiles + x);
+        }
+        for (int i = 0; (i < profile.collectibleCount) && !reachableCells.empty(); ++i) {
+            auto index = randomInt(rng, 0, static_cast<int>(std::ssize(reachableCells)) - 1);
+            auto cell = reachableCells[index];
+            reachableCells[index] = reachableCells.back();
+            reachableCells.pop_back();
+            level.collectibles.emplace_back(static_cast<float>((cell % widthTiles) * tileSize), static_cast<float>((cell / widthTiles) * tileSize));
+        }
+
+        auto generationTime = (GetTime() - startTime) * 1000.0;
+        TraceLog(LOG_INFO, (ZSTR() << "Generated level with seed " << seed << " in " << generationTime << " ms (" << level.attempts << " attempts).").str().c_str());
+        return level;
+    }
+
+    ZTHROW() << "Could not generate a beatable level with seed " << seed << " in " << profile.maxAttempts << " attempts.";
+}
+
+void LevelGenerator::buildCandidate(std::mt19937& rng, const DifficultyProfile& profile, GeneratedLevel& level) {
+    auto width = profile.levelWidth;
+    auto height = profile.levelHeight;
+    auto tileSize = level.tileSize;
+
+    level.levelData.assign(width * height, static_cast<int8_t>(TileType::EMPTY));
+    level.collectibles.clear();
+
+    auto setTile = [&](int x, int y, TileType tile) {
+        if ((x < 0) || (y < 0) || (x >= width) || (y >= height)) return;
+        level.levelData[y * width + x] = static_cast<int8_t>(tile);
+    };
+
+    auto topFloor = height - 20;
+    auto bottomFloor = height - 4;
+    auto floorY = height - 8;   // First row of the ground.
+    auto x = 0;
+    auto first = true;
+
+    while (true) {
+        auto length = first ? std::max(profile.minPlatformLength, 6) : randomInt(rng, profile.minPlatformLength, profile.maxPlatformLength);
+        auto last = x + length + profile.maxGap + profile.maxPlatformLength >= width;
+        if (last)
+            length = width - x;
+
+        for (int px = x; px < x + length; ++px)
+            for (int py = floorY; py < height; ++py)
+                setTile(px, py, TileType::WALL);
+
+        if (first)
+            level.playerStartPosition = raylib::Vector2{ (x + 2) * tileSize + tileSize / 2.0f, floorY * tileSize - 1.0f };
+
+        x += length;
+        first = false;
+
+        if (last) {
+            // Same offsets from the ground as in hand-made levels.
+            auto doorX = (width - 4) * tileSize;
+            auto groundY = floorY * tileSize;
+            level.levelExit = raylib::Rectangle{ doorX - 4.0f, groundY - 40.0f, 30.0f, 50.0f };
+            level.levelExitDoor = raylib::Rectangle{ static_cast<float>(doorX), groundY - 7.0f, 22.0f, 48.0f };
+            break;
+        }
+
+        auto gap = randomInt(rng, profile.minGap, profile.maxGap);
+        for (int gx = x; gx < x + gap; ++gx) {
+            setTile(gx, height - 1, TileType::WALL);
+            setTile(gx, height - 2, TileType::LAVA);
+        }
+
+        if ((gap >= 3) && (randomFloat(rng) < profile.floatingPlatformChance)) {
+            auto floatingLength = std::min(gap - 1, 3);
+            auto floatingX = x + (gap - floatingLength) / 2;
+            auto floatingY = floorY - randomInt(rng, 3, 5);
+            for (int fx = floatingX; fx < floatingX + floatingLength; ++fx)
+                setTile(fx, floatingY, TileType::WALL);
+        }
+
+        x += gap;
+        floorY = std::clamp(floorY + randomInt(rng, -profile.maxStepUp, profile.maxStepDown), topFloor, bottomFloor);
+    }
+}
+
+void LevelGenerator::findPlatforms(const GeneratedLevel& level) {
+    auto widthTiles = level.levelWidth / level.tileSize;
+    auto heightTiles = level.levelHeight / level.tileSize;
+
+    platforms.clear();
+    cellPlatform.assign(widthTiles * heightTiles, -1);
+
+    for (int y = 0; y < heightTiles - 1; ++y) {
+        for (int x = 0; x < widthTiles; ++x) {
+            auto tile = scratchLevel.getTileRaw(x, y).value_or(TileType::WALL);
+            auto below = scratchLevel.getTileRaw(x, y + 1).value_or(TileType::WALL);
+            if (isCollider(tile) || (below != TileType::WALL))
+                continue;
+
+            if ((x > 0) && (cellPlatform[y * widthTiles + x - 1] >= 0)) {
+                auto index = cellPlatform[y * widthTiles + x - 1];
+                platforms[index].x1 = x;
+                cellPlatform[y * widthTiles + x] = index;
+            }
+            else {
+                cellPlatform[y * widthTiles + x] = static_cast<int>(std::ssize(platforms));
+                platforms.push_back(Platform{ y, x, x });
+            }
+        }
+    }
+}
+
+int LevelGenerator::platformAt(int x, int y) const {
+    auto widthTiles = scratchLevel.levelWidth / scratchLevel.tileSize;
+    auto heightTiles = scratchLevel.levelHeight / scratchLevel.tileSize;
+    if ((x < 0) || (y < 0) || (x >= widthTiles) || (y >= heightTiles))
+        return -1;
+    return cellPlatform[y * widthTiles + x];
+}
+
+std::vector<bool> LevelGenerator::findReachablePlatforms(const GeneratedLevel& level, const PlayerModel& player) {
+    auto tileSize = level.tileSize;
+
+    std::vector<bool> reachable(platforms.size(), false);
+    std::deque<int> queue;
+
+    auto startPlatform = platformAt(static_cast<int>(level.playerStartPosition.x) / tileSize, static_cast<int>(level.playerStartPosition.y) / tileSize);
+    ZASSERT(startPlatform >= 0);
+    reachable[startPlatform] = true;
+    queue.push_back(startPlatform);
+
+    while (!queue.empty()) {
+        auto platform = platforms[queue.front()];
+        queue.pop_front();
+
+        auto groundY = platform.y * tileSize + tileSize - 1.0f;
+        auto leftX = platform.x0 * tileSize + tileSize / 2.0f;
+        auto rightX = platform.x1 * tileSize + tileSize / 2.0f;
+        auto centerX = (leftX + rightX) / 2.0f;
+
+        // Landing anywhere on a platform means the whole platform is reachable, so we only jump from edges and center.
+        struct Move { float x; float velocityX; int axisX; float jumpHoldTime; };
+        const Move moves[] = {
+            { leftX, -player.physics.landMaxSpeed, -1, 0.0f },
+            { leftX, -player.physics.landMaxSpeed, -1, player.physics.jumpAccelerationTime },
+            { leftX, 0.0f, -1, player.physics.jumpAccelerationTime },
+            { leftX, 0.0f, -1, player.physics.jumpAccelerationTime / 2.0f },
+            { rightX, player.physics.landMaxSpeed, 1, 0.0f },
+            { rightX, player.physics.landMaxSpeed, 1, player.physics.jumpAccelerationTime },
+            { rightX, 0.0f, 1, player.physics.jumpAccelerationTime },
+            { rightX, 0.0f, 1, player.physics.jumpAccelerationTime / 2.0f },
+            { centerX, 0.0f, 0, player.physics.jumpAccelerationTime },
+            { centerX, 0.0f, -1, player.physics.jumpAccelerationTime },
+            { centerX, 0.0f, 1, player.physics.jumpAccelerationTime },
+        };
+
+        for (const auto& move : moves) {
+            auto landed = simulateJump(player, raylib::Vector2{ move.x, groundY }, move.velocityX, move.axisX, move.jumpHoldTime);
+            if (landed && !reachable[*landed]) {
+                reachable[*landed] = true;
+                queue.push_back(*landed);
+            }
+        }
+    }
+
+    return reachable;
+}
+
+std::optional<int> LevelGenerator::simulateJump(const PlayerModel& player, raylib::Vector2 position, float velocityX, int axisX, float jumpHoldTime) {
+    const auto tileSize = static_cast<float>(scratchLevel.tileSize);
+    const auto maxFlightTime = 3.0f;
+    const auto timeDelta = 1.0f / 60.0f / Player::physicsSteps;
+
+    PlayerMotion motion;
+    motion.position = position;
+    motion.velocity = { velocityX, 0.0f };
+    auto leftGround = false;
+
+    for (float time = 0.0f; time < maxFlightTime; time += timeDelta) {
+        PlayerInput input;
+        input.axisX = axisX;
+        input.jump = time < jumpHoldTime;
+        stepPlayerPhysics(player.physics, motion, input, scratchLevel, player.origin, time, timeDelta);
+
+        if (leftGround && (motion.state == PlayerState::GROUNDED)) {
+            if (scratchLevel.getTileWorld(motion.position + raylib::Vector2(0, tileSize / 2.0f)).value_or(TileType::EMPTY) == TileType::LAVA)
+                return {};
+            auto groundRow = static_cast<int>(motion.position.y + tileSize / 2.0f) / static_cast<int>(tileSize);
+            auto column = static_cast<int>(motion.position.x) / static_cast<int>(tileSize);
+            for (auto dx : { 0, -1, 1 }) {
+                auto platform = platformAt(column + dx, groundRow - 1);
+                if (platform >= 0)
+                    return platform;
+            }
+            return {};
+        }
+        if (motion.state != PlayerState::GROUNDED)
+            leftGround = true;
+    }
+
+    return {};
+}
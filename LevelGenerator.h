@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Level.h"
+#include "Player.h"
+
+#include "raylib-cpp.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+
+class Game;
+
+
+/// Parameters that control how hard a generated level is.
+/// All lengths are in tiles.
+struct DifficultyProfile {
+    int levelWidth;                 ///< Width of the level.
+    int levelHeight;                ///< Height of the level.
+    int minPlatformLength;          ///< Shortest ground platform.
+    int maxPlatformLength;          ///< Longest ground platform.
+    int minGap;                     ///< Narrowest lava pit between platforms.
+    int maxGap;                     ///< Widest lava pit between platforms.
+    int maxStepUp;                  ///< How much higher next platform can be.
+    int maxStepDown;                ///< How much lower next platform can be.
+    float floatingPlatformChance;   ///< Chance (0-1) of a floating platform above a pit.
+    int collectibleCount;           ///< Number of collectibles to place on reachable platforms.
+    int maxAttempts;                ///< How many candidates to try before giving up.
+
+    static DifficultyProfile fromJson(const nlohmann::json& json);
+};
+
+/// Level produced by LevelGenerator. Positions are in world coordinates, same as LDtk entities.
+struct GeneratedLevel {
+    int tileSize = 16;
+    int levelWidth = 0;                         ///< Width of the level in pixels.
+    int levelHeight = 0;                        ///< Height of the level in pixels.
+    std::vector<int8_t> levelData;              ///< Same layout as Level::levelData.
+    raylib::Vector2 playerStartPosition = { 0.0f, 0.0f };
+    raylib::Rectangle levelExit = { 0.0f, 0.0f, 0.0f, 0.0f };
+    raylib::Rectangle levelExitDoor = { 0.0f, 0.0f, 0.0f, 0.0f };
+    std::vector<raylib::Vector2> collectibles;
+    int attempts = 0;                           ///< Number of candidates generated, including the accepted one.
+};
+
+/// Generates levels from a seed and a DifficultyProfile.
+/// Every candidate is validated by simulating jumps with the player's physics (same tuning, same time step
+/// and Level::collisionDetection), and candidates where the exit can't be reached are rejected.
+class LevelGenerator {
+private:
+    Game& game;
+    Level scratchLevel;                 ///< Holds tiles of the candidate being validated.
+
+    std::string pregeneratedFile;       ///< Level file that pregenerated was generated for.
+    GeneratedLevel pregenerated;
+    std::future<void> pregeneration;    ///< Fills pregenerated on Game::jobSystem. Members above (and scratch data) belong to it until it is done.
+
+    /// Horizontal run of tiles the player can stand on.
+    struct Platform {
+        int y;      ///< Row of empty tiles above the ground.
+        int x0;     ///< First column.
+        int x1;     ///< Last column (inclusive).
+    };
+
+    std::vector<Platform> platforms;
+    std::vector<int> cellPlatform;      ///< Index into platforms for every tile, or -1.
+
+    /// Player movement that levels are validated with. Copied from Player on the main thread, because the main thread
+    /// can reload the player (Player::load) at any time while pregeneration runs.
+    struct PlayerModel {
+        PlayerPhysics physics;
+        raylib::Vector2 origin;         ///< Sprite origin the hitbox is relative to.
+    };
+
+public:
+    LevelGenerator(Game& game);
+    ~LevelGenerator();
+
+    /// Generates a level. Throws if no valid level was found in profile.maxAttempts. Call from the main thread.
+    GeneratedLevel generate(uint32_t seed, const DifficultyProfile& profile, int tileSize);
+
+    /// Generates level described by "generator" section of a level file.
+    /// Returns pregenerated level if it was prepared for this file.
+    GeneratedLevel generateForLevel(const std::string& levelFile, const nlohmann::json& generatorJson, int tileSize);
+
+    /// Starts generating level in the background, so that Level::load doesn't have to. Does nothing for LDtk levels.
+    void pregenerate(const std::string& levelFile);
+
+    /// Waits until pregeneration started by pregenerate() is done.
+    void waitForPregeneration();
+
+private:
+    PlayerModel copyPlayer() const;
+    GeneratedLevel generate(uint32_t seed, const DifficultyProfile& profile, int tileSize, const PlayerModel& player);
+
+    void buildCandidate(std::mt19937& rng, const DifficultyProfile& profile, GeneratedLevel& level);
+    void findPlatforms(const GeneratedLevel& level);
+
+    /// @returns Which platforms are reachable from the player start.
+    std::vector<bool> findReachablePlatforms(const GeneratedLevel& level, const PlayerModel& player);
+
+    /// Simulates the player jumping (or walking off a ledge) with stepPlayerPhysics(), same as Player::step.
+    /// @param jumpHoldTime     How long jump button is held. Zero to just walk.
+    /// @returns Index of the platform player landed on, or nothing if player died or didn't land.
+    std::optional<int> simulateJump(const PlayerModel& player, raylib::Vector2 position, float velocityX, int axisX, float jumpHoldTime);
+
+    int platformAt(int x, int y) const;
+};
@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+
+#if defined(PLATFORM_WEB)
+#include <fstream>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#if defined(PLATFORM_WEB)
+
+bool MappedFile::open(const std::string& fileName) {
+    close();
+    std::ifstream input(fileName, std::ios::binary | std::ios::ate);
+    if (!input)
+        return false;
+    buffer.resize(static_cast<size_t>(input.tellg()));
+    input.seekg(0);
+    if (buffer.empty() || !input.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) {
+        buffer.clear();
+        return false;
+    }
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+}
+
+void MappedFile::close() {
+    buffer.clear();
+    buffer.shrink_to_fit();
+    data = nullptr;
+    size = 0;
+}
+
+#elif defined(_WIN32)
+
+bool MappedFile::open(const std::string& fileName) {
+    close();
+    auto file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0)) {
+        close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+
+    data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data)
+        UnmapViewOfFile(data);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+    data = nullptr;
+    size = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& fileName) {
+    close();
+    auto file = ::open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStat;
+    if ((fstat(file, &fileStat) != 0) || (fileStat.st_size == 0)) {
+        ::close(file);
+        return false;
+    }
+
+    auto mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); // Mapping stays valid.
+    if (mapping == MAP_FAILED)
+        return false;
+
+    data = static_cast<const unsigned char*>(mapping);
+    size = static_cast<size_t>(fileStat.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data)
+        munmap(const_cast<unsigned char*>(data), size);
+    data = nullptr;
+    size = 0;
+}
+
+#endif
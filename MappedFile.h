@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/// Read-only view of a whole file, mapped into memory.
+/// On the Web there is no real mapping, so the file is read into memory instead.
+/// @note Doesn't include raylib, because it conflicts with windows.h.
+class MappedFile {
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+#if defined(PLATFORM_WEB)
+    std::vector<unsigned char> buffer;
+#elif defined(_WIN32)
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    /// @returns False if file couldn't be opened or mapped.
+    bool open(const std::string& fileName);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    const unsigned char* getData() const { return data; }
+    size_t getSize() const { return size; }
+};
@@ -2,10 +2,10 @@
 
 #include "Game.h"
 #include "Utilities.h"
+#include "BakedFont.h"
 
+#include <cmath>
 #include <vector>
-#include <tuple>
-#include <functional>
 
 #include "raygui.h"
 
@@ -14,11 +14,14 @@
 
 Menu::Menu(Game& game)
     : game(game)
-    , charset(loadCharset("Graphics/Fonts/charset.txt"))
-    , menuFont("Graphics/Fonts/zekton-free.rg-regular.otf", 16, charset.data(), std::ssize(charset))
+    , menuFont(loadFont("Graphics/Fonts/zekton-free.rg-regular.otf", 16, "Graphics/Fonts/charset.txt"))
     , futharkFont("Graphics/Fonts/futhark.png")
 {}
 
+const std::string& Menu::getText(std::u32string_view text) {
+    return game.textCache.getText(text, !useFuthark, !useFuthark);
+}
+
 void Menu::update() {
     if (!inMenu && game.isInputPressed(InputButton::MENU)) {
         show(true);
@@ -31,22 +34,38 @@ void Menu::update() {
     }
 }
 
-void Menu::draw() {
-    if (!inMenu) {
-        return;
-    }
-
-    if (useFuthark) {
-        GuiSetFont(futharkFont);
-    } else {
-        GuiSetFont(menuFont);
-    }
+bool Menu::itemsChanged() const {
+    return !itemsValid
+        || (game.gameState != shownGameState)
+        || (episodeSelect != shownEpisodeSelect)
+        || (useFuthark != shownUseFuthark)
+        || (game.window.IsFullscreen() != shownFullscreen)
+        || (game.debug != shownDebug)
+        || (game.currentLevel != shownLevel)
+        || (game.currentEpisode != shownEpisode)
+        || (game.level.levelDescription != shownLevelDescription);
+}
 
+void Menu::rebuildItems() {
+    shownGameState = game.gameState;
+    shownEpisodeSelect = episodeSelect;
+    shownUseFuthark = useFuthark;
+    shownFullscreen = game.window.IsFullscreen();
+    shownDebug = game.debug;
+    shownLevel = game.currentLevel;
+    shownEpisode = game.currentEpisode;
+    shownLevelDescription = game.level.levelDescription;
+    itemsValid = true;
+
+    auto& font = (useFuthark ? futharkFont : menuFont);
+    auto fontSize = static_cast<float>(font.baseSize);
+
+    std::string headerText;
     if (game.gameState != GameState::START_SCREEN) {
         auto numEpisodes = game.episodes.contains(game.currentEpisode) ? std::ssize(game.episodes.at(game.currentEpisode)) : -1;
-        auto& curFont = (useFuthark ? futharkFont : menuFont);
-        curFont.DrawText((ZSTR() << "LEVEL: " << textForFont(!useFuthark, !useFuthark, game.currentEpisode) << ": " << textForFont(!useFuthark, !useFuthark, game.level.levelDescription) << " " << game.currentLevel + 1 << " / " << numEpisodes).str().c_str(), {10, 10}, curFont.baseSize, 1.0f, BLUE);
+        headerText = (ZSTR() << "LEVEL: " << getText(game.currentEpisode) << ": " << getText(game.level.levelDescription) << " " << game.currentLevel + 1 << " / " << numEpisodes).str();
     }
+    header.layout(font, headerText, fontSize, 1.0f);
 
 #if defined(PLATFORM_WEB)
     const bool webBuild = true;
@@ -58,78 +77,80 @@ void Menu::draw() {
     float buttonX = menuRectangle.x + (menuRectangle.width - buttonWidth) / 2;
     auto yPosition = menuRectangle.y;
 
-    std::vector< std::tuple< std::function<void()>, std::function<void()> > > items;
-    auto addItem = [&items, &yPosition](std::tuple< std::function<void()>, std::function<void()> > item) {
-        items.push_back(item);
+    items.clear();
+    auto addItem = [&](MenuAction action, int icon, std::u32string_view label, std::u32string episodeName = {}) {
+        const auto& text = game.textCache.getGlyphRun(font, fontSize, 1.0f, label, !useFuthark, !useFuthark);
+        items.push_back({ action, icon, text, raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, std::move(episodeName) });
         yPosition += 50.0f;
     };
 
     if (episodeSelect) {
         for (const auto& [episodeName, levelFiles] : game.episodes) {
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, textForFont(!useFuthark, !useFuthark, episodeName).c_str()); },
-                [=, this]() { game.currentEpisode = episodeName; game.startLevel(0); },
-            });
+            if (game.debugEpisodes.contains(episodeName) && !game.debug)
+                continue;
+            addItem(MenuAction::SELECT_EPISODE, -1, episodeName, episodeName);
         }
-        addItem({
-            [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_UNDO_FILL, textForFont(!useFuthark, !useFuthark, U"Wstecz").c_str())); },
-            [=, this]() { episodeSelect = false; focusedItem = 0; },
-        });
+        addItem(MenuAction::BACK, ICON_UNDO_FILL, U"Wstecz");
     }
     else {
         if (game.gameState == GameState::START_SCREEN)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_PLAYER_PLAY, textForFont(!useFuthark, !useFuthark, U"Nowa gra").c_str())); },
-                [=, this]() { game.load("Levels/Levels.json"); episodeSelect = true; focusedItem = 0; },
-            });
+            addItem(MenuAction::NEW_GAME, ICON_PLAYER_PLAY, U"Nowa gra");
         if (game.gameState == GameState::LEVEL)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_UNDO_FILL, textForFont(!useFuthark, !useFuthark, U"Wróć do gry").c_str())); },
-                [=, this]() { show(false); },
-            });
+            addItem(MenuAction::RESUME, ICON_UNDO_FILL, U"Wróć do gry");
         if ((game.gameState == GameState::LEVEL) || (game.gameState == GameState::LEVEL_DIED))
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_REDO_FILL, textForFont(!useFuthark, !useFuthark, U"Restart poziomu").c_str())); },
-                [=, this]() { game.restartLevel(); },
-            });
+            addItem(MenuAction::RESTART_LEVEL, ICON_REDO_FILL, U"Restart poziomu");
         if (game.gameState == GameState::LEVEL)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_PLAYER_NEXT, textForFont(!useFuthark, !useFuthark, U"Zakończ poziom").c_str())); },
-                [=, this]() { game.endLevel(false); },
-            });
+            addItem(MenuAction::END_LEVEL, ICON_PLAYER_NEXT, U"Zakończ poziom");
         if (game.gameState != GameState::START_SCREEN)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_REREDO_FILL, textForFont(!useFuthark, !useFuthark, U"Restart gry").c_str())); },
-                [=, this]() { game.restartGame(); },
-            });
-        if (false)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_FILE_SAVE, textForFont(!useFuthark, !useFuthark, U"Zapisz").c_str())); },
-                [=, this]() {},
-            });
-        if (false)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_TARGET_MOVE_FILL, textForFont(!useFuthark, !useFuthark, U"Sterowanie").c_str())); },
-                [=, this]() {},
-            });
+            addItem(MenuAction::RESTART_GAME, ICON_REREDO_FILL, U"Restart gry");
         if (!webBuild)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_CURSOR_SCALE, textForFont(!useFuthark, !useFuthark, game.window.IsFullscreen() ? U"W oknie" : U"Pełny ekran").c_str())); },
-                [=, this]() { game.window.ToggleFullscreen(); },
-            });
-        addItem({
-            [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_GEAR_BIG, textForFont(!useFuthark, !useFuthark, useFuthark ? U"Polish" : U"Futhark").c_str())); },
-            [=, this]() {
-                useFuthark = !useFuthark;
-                game.reloadScenes(useFuthark, true);
-            },
-            });
+            addItem(MenuAction::TOGGLE_FULLSCREEN, ICON_CURSOR_SCALE, shownFullscreen ? U"W oknie" : U"Pełny ekran");
+        addItem(MenuAction::TOGGLE_LANGUAGE, ICON_GEAR_BIG, useFuthark ? U"Polish" : U"Futhark");
         if (!webBuild)
-            addItem({
-                [=, this]() { GuiButton(raylib::Rectangle { buttonX, yPosition, buttonWidth, 30 }, GuiIconText(ICON_EXIT, textForFont(!useFuthark, !useFuthark, U"Wyjdź z gry").c_str())); },
-                [=, this]() { game.shouldQuit = true; },
-            });
+            addItem(MenuAction::QUIT, ICON_EXIT, U"Wyjdź z gry");
+    }
+}
+
+void Menu::activate(const MenuItem& item) {
+    switch (item.action) {
+    case MenuAction::SELECT_EPISODE: game.currentEpisode = item.episodeName; game.startLevel(0); break;
+    case MenuAction::BACK: episodeSelect = false; focusedItem = 0; break;
+    case MenuAction::NEW_GAME: game.load("Levels/Levels.json"); episodeSelect = true; focusedItem = 0; break;
+    case MenuAction::RESUME: show(false); break;
+    case MenuAction::RESTART_LEVEL: game.restartLevel(); break;
+    case MenuAction::END_LEVEL: game.endLevel(false); break;
+    case MenuAction::RESTART_GAME: game.restartGame(); break;
+    case MenuAction::TOGGLE_FULLSCREEN: game.window.ToggleFullscreen(); break;
+    case MenuAction::TOGGLE_LANGUAGE:
+    {
+        // Both scripts are already loaded (or loading), so this only swaps pointers. TextCache keeps texts for both.
+        auto toggleStartTime = GetTime();
+        useFuthark = !useFuthark;
+        game.setScenesUseFuthark(useFuthark);
+        TraceLog(LOG_INFO, (ZSTR() << "Language toggled in " << (GetTime() - toggleStartTime) * 1000.0 << " ms" << (game.resourceCache.isGroupLoaded(Game::scriptVariantLoadGroup) ? "" : ", other script still loading")).str().c_str());
+        break;
+    }
+    case MenuAction::QUIT: game.shouldQuit = true; break;
     }
+    itemsValid = false; // Actions can change anything, even the episode list.
+}
+
+void Menu::draw() {
+    if (!inMenu) {
+        return;
+    }
+
+    if (useFuthark) {
+        GuiSetFont(futharkFont);
+    } else {
+        GuiSetFont(menuFont);
+    }
+
+    if (itemsChanged())
+        rebuildItems();
+
+    auto layer = static_cast<int>(SpriteLayer::HUD);
+    header.draw(game.spriteBatch, { 10.0f, 10.0f }, BLUE, layer);
 
     auto numItems = static_cast<int>(std::ssize(items));
 
@@ -147,16 +168,36 @@ void Menu::draw() {
     else
         yaxisBlocked = false;
 
+    // raygui would measure and lay out button labels on every frame, so it draws only the buttons, and labels are drawn
+    // from glyph runs on top of them, centered the same way.
+    constexpr float iconSize = 16.0f;           // RAYGUI_ICON_SIZE
+    constexpr float iconTextPadding = 4.0f;     // ICON_TEXT_PADDING in raygui.
+    auto mousePosition = GetMousePosition();
     for (int i = 0; i < numItems; ++i) {
-        auto& [buttonFunc, actionFunc] = items[i];
+        const auto& item = items[i];
         if (i == focusedItem) GuiSetState(STATE_FOCUSED);
-        buttonFunc();
+        GuiButton(item.bounds, "");
         if (i == focusedItem) GuiSetState(STATE_NORMAL);
+
+        // Same state as raygui uses for the button, so the label has the matching color.
+        int state = (i == focusedItem) ? STATE_FOCUSED : STATE_NORMAL;
+        if (CheckCollisionPointRec(mousePosition, item.bounds))
+            state = IsMouseButtonDown(MOUSE_BUTTON_LEFT) ? STATE_PRESSED : STATE_FOCUSED;
+        auto color = GetColor(GuiGetStyle(BUTTON, TEXT_COLOR_NORMAL + state * 3));
+
+        auto labelSize = item.label.getSize();
+        auto width = labelSize.x + ((item.icon >= 0) ? iconSize + iconTextPadding : 0.0f);
+        auto x = std::floor(item.bounds.x + (item.bounds.width - width) / 2.0f);
+        auto y = std::floor(item.bounds.y + (item.bounds.height - labelSize.y) / 2.0f);
+        if (item.icon >= 0) {
+            GuiDrawIcon(item.icon, static_cast<int>(x), static_cast<int>(item.bounds.y + (item.bounds.height - iconSize) / 2.0f), 1, color);
+            x += iconSize + iconTextPadding;
+        }
+        item.label.draw(game.spriteBatch, { x, y }, color, layer);
     }
+    game.flushSprites();
 
-    auto& [buttonFunc, actionFunc] = items[focusedItem];
     if (game.isInputPressed(InputButton::MENU_ACTION)) { // A
-        actionFunc();
+        activate(items[focusedItem]);
     }
 }
-
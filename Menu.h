@@ -1,10 +1,40 @@
 #pragma once
 
 
+#include "GlyphRun.h"
+
 #include "raylib-cpp.hpp"
 
+#include <string>
+#include <string_view>
+#include <vector>
+
 
 class Game;
+enum class GameState;
+
+
+/// What happens when a menu item is activated.
+enum class MenuAction {
+    SELECT_EPISODE,
+    BACK,
+    NEW_GAME,
+    RESUME,
+    RESTART_LEVEL,
+    END_LEVEL,
+    RESTART_GAME,
+    TOGGLE_FULLSCREEN,
+    TOGGLE_LANGUAGE,
+    QUIT,
+};
+
+struct MenuItem {
+    MenuAction action;
+    int icon;                       ///< raygui icon drawn before the label, or -1.
+    GlyphRun label;                 ///< Laid out with the menu font, so drawing it doesn't measure anything.
+    raylib::Rectangle bounds;
+    std::u32string episodeName;     ///< For MenuAction::SELECT_EPISODE.
+};
 
 
 class Menu {
@@ -18,9 +48,21 @@ private:
 
     raylib::Rectangle menuRectangle = { 0.0f, 0.0f, 1000.0f, 500.0f };
 
+    /// Menu items are rebuilt only when something they depend on changes.
+    std::vector<MenuItem> items;
+    GlyphRun header;                ///< Empty on the start screen.
+    bool itemsValid = false;
+    GameState shownGameState;
+    bool shownEpisodeSelect = false;
+    bool shownUseFuthark = false;
+    bool shownFullscreen = false;
+    bool shownDebug = false;
+    std::u32string shownEpisode;
+    int shownLevel = -1;
+    std::u32string shownLevelDescription;
+
 public:
-    std::vector<int> charset;   ///< Currently only menuFont supports this.
-    raylib::Font menuFont;
+    raylib::Font menuFont;      ///< Baked by Tools/FontBaker.cpp, see BakedFont.h.
     raylib::Font futharkFont;
 
 public:
@@ -31,7 +73,7 @@ public:
 
     bool isInMenu() const { return inMenu; }
     void setInMenu(bool inMenu) { this->inMenu = inMenu; focusedItem = 0; episodeSelect = false; }
-    void setMenuRectangle(raylib::Rectangle menuRectangle) { this->menuRectangle = menuRectangle; }
+    void setMenuRectangle(raylib::Rectangle menuRectangle) { this->menuRectangle = menuRectangle; itemsValid = false; }
 
     void show(bool doShow)
     {
@@ -43,5 +85,13 @@ public:
 
     void update();
     void draw();
+
+private:
+    /// @returns Text converted for current menu font.
+    const std::string& getText(std::u32string_view text);
+
+    bool itemsChanged() const;
+    void rebuildItems();
+    void activate(const MenuItem& item);
 };
 
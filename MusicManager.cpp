@@ -0,0 +1,157 @@
+#include "MusicManager.h"
+
+#include "FileSystem.h"
+
+#include "zstr.h"
+#include "zerrors.h"
+
+#include <algorithm>
+
+
+MusicManager::MusicManager() {
+#if !defined(PLATFORM_WEB) // We don't build with pthreads on the Web.
+    audioThread = std::thread([this]() { audioLoop(); });
+#endif
+}
+
+MusicManager::~MusicManager() {
+    if (audioThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quitting = true;
+        }
+        quitRequested.notify_all();
+        audioThread.join();
+    }
+}
+
+ResourceId MusicManager::get(const std::string& fileName) {
+    auto id = paths.intern(fileName);
+    int frames;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if ((id < std::ssize(streams)) && streams[id])
+            return id;
+        frames = bufferFrames;
+    }
+
+    auto stream = loadStream(id, frames);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id >= std::ssize(streams))
+        streams.resize(id + 1);
+    streams[id] = std::move(stream);
+    return id;
+}
+
+std::unique_ptr<MusicManager::Stream> MusicManager::loadStream(ResourceId id, int frames) {
+    // raylib takes buffer size of new streams from a global.
+    SetAudioStreamBufferSizeDefault(frames);
+    auto stream = std::make_unique<Stream>();
+    loadMusicFile(stream->music, paths.getPath(id));
+    stream->bufferFrames = frames;
+    ++loadCount;
+    TraceLog(LOG_INFO, (ZSTR() << "Music '" << paths.getPath(id) << "' loaded, " << frames << " frames buffer").str().c_str());
+    return stream;
+}
+
+void MusicManager::play(ResourceId music, float volume, bool restart) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ZASSERT((music >= 0) && (music < std::ssize(streams)) && streams[music]) << "Music " << music << " is not loaded.";
+    auto& stream = *streams[music];
+    stream.music.SetVolume(volume);
+    if (stream.playing && !restart)
+        return;
+    stream.music.Seek(0);
+    stream.music.Play();
+    stream.playing = true;
+    stream.lastRefill = std::chrono::steady_clock::now();
+}
+
+void MusicManager::stop(ResourceId music) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ZASSERT((music >= 0) && (music < std::ssize(streams)) && streams[music]) << "Music " << music << " is not loaded.";
+    auto& stream = *streams[music];
+    stream.music.Stop();
+    stream.playing = false;
+}
+
+void MusicManager::setBufferFrames(int frames) {
+    ZASSERT(frames > 0) << "Invalid music buffer size: " << frames;
+    std::vector<ResourceId> stale;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bufferFrames = frames;
+        for (ResourceId id = 0; id < std::ssize(streams); ++id) {
+            if (streams[id] && !streams[id]->playing && (streams[id]->bufferFrames != frames))
+                stale.push_back(id);
+        }
+    }
+
+    // Only the main thread starts streams, so ones that weren't playing are still stopped when the reloaded ones are swapped in.
+    for (auto id : stale) {
+        auto stream = loadStream(id, frames);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(streams[id], stream);
+        }
+        // Old stream is unloaded here, outside of the lock.
+    }
+}
+
+int MusicManager::getBufferFrames() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bufferFrames;
+}
+
+void MusicManager::update() {
+    if (audioThread.joinable())
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    refill();
+}
+
+int MusicManager::getUnderrunCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return underrunCount;
+}
+
+double MusicManager::getMaxRefillGap() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxRefillGap;
+}
+
+void MusicManager::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    underrunCount = 0;
+    maxRefillGap = 0.0;
+}
+
+void MusicManager::audioLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!quitting) {
+        refill();
+        // Refill a few times per buffer half, so a late wake-up doesn't cause a dropout. Assumes 48 kHz, lower rates only have more slack.
+        auto interval = std::chrono::microseconds(std::max(1000LL, bufferFrames * 1000000LL / 48000 / 4));
+        quitRequested.wait_for(lock, interval, [this]() { return quitting; });
+    }
+}
+
+void MusicManager::refill() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& stream : streams) {
+        if (!stream || !stream->playing)
+            continue;
+
+        // Stream buffer has two halves. If none was refilled while both were played, stream ran dry.
+        auto gap = std::chrono::duration<double>(now - stream->lastRefill).count();
+        auto bufferDuration = 2.0 * stream->bufferFrames / std::max(1u, stream->music.stream.sampleRate);
+        maxRefillGap = std::max(maxRefillGap, gap);
+        if (gap > bufferDuration)
+            ++underrunCount;
+
+        stream->music.Update();
+        stream->lastRefill = now;
+        if (!stream->music.IsPlaying())
+            stream->playing = false;     // Not looped music has ended.
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "PathInterner.h"
+
+#include "raylib-cpp.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/// Keeps music streams loaded, so levels and scenes that use the same music share it, and reloads don't load it again.
+/// Streams are refilled by an audio thread, so long frames and loading stalls don't starve them.
+/// All access to the streams goes through the manager, because raylib streams can't be used from two threads at once.
+class MusicManager {
+public:
+    static constexpr int defaultBufferFrames = 8192;    ///< Frames in each of the two halves of a stream buffer.
+
+private:
+    struct Stream {
+        raylib::Music music;
+        int bufferFrames = 0;       ///< Buffer size the stream was loaded with.
+        bool playing = false;
+        std::chrono::steady_clock::time_point lastRefill;
+    };
+
+    PathInterner paths;
+    std::vector<std::unique_ptr<Stream>> streams;   ///< Indexed by id from paths. Guarded by mutex.
+    int bufferFrames = defaultBufferFrames;         ///< Guarded by mutex.
+    int loadCount = 0;
+
+    std::thread audioThread;            ///< Not started on the Web, update() refills streams there instead.
+    std::mutex mutex;
+    std::condition_variable quitRequested;
+    bool quitting = false;              ///< Guarded by mutex.
+
+    int underrunCount = 0;              ///< Guarded by mutex.
+    double maxRefillGap = 0.0;          ///< Longest time between refills of a playing stream (in seconds). Guarded by mutex.
+
+public:
+    MusicManager();
+    ~MusicManager();
+
+    MusicManager(const MusicManager&) = delete;
+    MusicManager& operator=(const MusicManager&) = delete;
+
+    /// @returns Id of the music, loading it if it isn't loaded yet. Loaded music is kept until the manager is destroyed.
+    ResourceId get(const std::string& fileName);
+
+    /// Plays music from the start (or keeps playing it, if restart is false and it is already playing).
+    void play(ResourceId music, float volume, bool restart = true);
+    void stop(ResourceId music);
+
+    /// Sets size of stream buffers. Bigger buffers survive longer stalls, but take longer to respond.
+    /// Streams that aren't playing are reloaded with the new size, playing ones keep the old one until they stop.
+    void setBufferFrames(int frames);
+    int getBufferFrames();
+
+    /// Refills streams on the Web, where there is no audio thread. Does nothing elsewhere. Call once per frame.
+    void update();
+
+    int getStreamCount() const { return paths.getCount(); }
+    int getLoadCount() const { return loadCount; }
+
+    /// @returns Number of times a playing stream wasn't refilled before its whole buffer was played, so there was a dropout.
+    int getUnderrunCount();
+    double getMaxRefillGap();
+    void resetStats();
+
+private:
+    void audioLoop();
+
+    /// Refills buffers of all playing streams. Mutex must be locked.
+    void refill();
+
+    /// Loads music without locking the mutex, so the audio thread can keep refilling other streams. Call only from the main thread.
+    std::unique_ptr<Stream> loadStream(ResourceId id, int frames);
+};
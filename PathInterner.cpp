@@ -0,0 +1,41 @@
+#include "PathInterner.h"
+
+
+std::string PathInterner::normalize(std::string_view path) {
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+ResourceId PathInterner::intern(std::string_view path) {
+    auto it = ids.find(path);
+    if (it != ids.end())
+        return it->second;
+
+    // New spelling. It may still be a path we know.
+    auto normalized = normalize(path);
+    auto normalizedIt = ids.find(normalized);
+    ResourceId id;
+    if (normalizedIt != ids.end()) {
+        id = normalizedIt->second;
+    }
+    else {
+        id = static_cast<ResourceId>(std::ssize(paths));
+        paths.push_back(normalized);
+        ids.try_emplace(std::move(normalized), id);
+    }
+
+    ids.try_emplace(std::string(path), id);
+    return id;
+}
+
+ResourceId PathInterner::intern(const std::filesystem::path& directory, std::string_view relativePath) {
+    return intern((directory / relativePath).generic_string());
+}
+
+ResourceId PathInterner::find(std::string_view path) const {
+    auto it = ids.find(path);
+    if (it != ids.end())
+        return it->second;
+
+    auto normalizedIt = ids.find(normalize(path));
+    return (normalizedIt != ids.end()) ? normalizedIt->second : invalidResourceId;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+/// Stable id of an interned path. Ids are small and dense, so they can index vectors.
+using ResourceId = int32_t;
+constexpr ResourceId invalidResourceId = -1;
+
+/// Assigns ids to file paths. Paths are normalized, so different spellings of the same file get the same id.
+class PathInterner {
+private:
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>()(text); }
+    };
+
+    std::unordered_map<std::string, ResourceId, StringHash, std::equal_to<>> ids;  ///< Both normalized paths, and spellings seen so far.
+    std::vector<std::string> paths;         ///< Normalized path of every id.
+
+public:
+    /// @returns Id of given path. Same path always gets the same id.
+    ResourceId intern(std::string_view path);
+
+    /// @returns Id of path relative to given directory.
+    ResourceId intern(const std::filesystem::path& directory, std::string_view relativePath);
+
+    /// @returns Id of given path, or invalidResourceId if it wasn't interned.
+    ResourceId find(std::string_view path) const;
+
+    const std::string& getPath(ResourceId id) const { return paths[id]; }
+    int getCount() const { return static_cast<int>(std::ssize(paths)); }
+
+    static std::string normalize(std::string_view path);
+};
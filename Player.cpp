@@ -13,29 +13,29 @@
 
 Player::Player(Game& game)
     : game(game)
-    , jumpSfx("Sounds/541210__eminyildirim__combat-whoosh.wav")
-    , groundSfx("Sounds/step.wav")
+    , jumpSfx(game.soundService.load("Sounds/541210__eminyildirim__combat-whoosh.wav", SoundSettings{ .maxVoices = 1, .priority = 2 }))
+    , groundSfx(game.soundService.load("Sounds/step.wav", SoundSettings{ .maxVoices = 2, .priority = 1 }))
 {
-    idleAnimation.load(game.resourceCache, "Graphics/Player/player-idle.json");
-    runAnimation.load(game.resourceCache, "Graphics/Player/player-run.json");
-    jumpUpAnimation.load(game.resourceCache, "Graphics/Player/player-jump-up.json");
-    jumpDownAnimation.load(game.resourceCache, "Graphics/Player/player-jump-down.json");
-    hurtAnimation.load(game.resourceCache, "Graphics/Player/player-hurt.json");
-    slideAnimation.load(game.resourceCache, "Graphics/Player/player-slide.json");
-    glideAnimation.load(game.resourceCache, "Graphics/Player/player-glide.json");
-    grabAnimation.load(game.resourceCache, "Graphics/Player/player-grab.json");
+    idleAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-idle.json");
+    runAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-run.json");
+    jumpUpAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-jump-up.json");
+    jumpDownAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-jump-down.json");
+    hurtAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-hurt.json");
+    slideAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-slide.json");
+    glideAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-glide.json");
+    grabAnimation.load(game.resourceCache, game.soundService, "Graphics/Player/player-grab.json");
     load();
 }
 
 void Player::update() {
-    animTime += game.levelTimeDelta;
+    animation.advance(game.levelTimeDelta);
+    playAnimationSound();
 
     if (playerDead)
         return;
 
-    auto steps = 20.0f;
-    auto timeDelta = game.levelTimeDelta / steps;
-    for (int i = 0; i < steps; ++i) {
+    auto timeDelta = game.levelTimeDelta / physicsSteps;
+    for (int i = 0; i < physicsSteps; ++i) {
         step(timeDelta);
     }
 
@@ -47,53 +47,53 @@ void Player::update() {
         DrawText("JUMP OWNED", 10, 70, 10, BLACK);
 }
 
-void Player::step(float timeDelta) {
-    int axisX = 0; // 1 is right, -1 is left.
+PlayerStepEvents stepPlayerPhysics(const PlayerPhysics& physics, PlayerMotion& motion, const PlayerInput& input, Level& level, raylib::Vector2 origin, float time, float timeDelta) {
+    PlayerStepEvents events;
+    auto axisX = input.axisX;
     auto buttonJump = false;
-    auto buttonGrab = false;
-    auto buttonGlide = false;
+    auto buttonGrab = input.grab;
+    auto buttonGlide = input.glide;
 
-    if (game.isInputDown(InputButton::RIGHT)) {
-        axisX += 1;
-    }
-    if (game.isInputDown(InputButton::LEFT)) {
-        axisX -= 1;
-    }
-
-    if (game.isInputDown(InputButton::JUMP) && !game.waitUntilJumpNotPressed) { // A
-        if (jumpButtonBlocked) {
-            DrawText("JUMP BLOCKED", 10, 60, 10, BLACK);
+    if (input.jump) {
+        if (motion.jumpButtonBlocked) {
+            events.jumpBlocked = true;
         } else {
-            DrawText("JUMP HELD", 10, 60, 10, BLACK);
+            events.jumpHeld = true;
             buttonJump = true;
-            jumpButtonLastPressTime = game.levelTime;
+            motion.jumpButtonLastPressTime = time;
         }
     } else {
-        jumpButtonBlocked = false;
+        motion.jumpButtonBlocked = false;
     }
 
-    if (game.levelTime <= jumpButtonLastPressTime + jumpButtonActiveTime) {
-        DrawText("JUMP HELD ARTIFICIALLY", 10, 50, 10, BLACK);
+    if (time <= motion.jumpButtonLastPressTime + physics.jumpButtonActiveTime) {
+        events.jumpHeldArtificially = true;
         buttonJump = true;
     }
     else {
-        if (!jumpButtonBlocked) jumpButtonOwned = false;
+        if (!motion.jumpButtonBlocked) motion.jumpButtonOwned = false;
     }
 
     // Check collisions and push back.
-    auto [origin, image, sound] = runAnimation.spriteForTime(animTime); // @todo Using anim for hitbox is broken here.
-    raylib::Rectangle currentHitbox = { position - origin + hitbox.GetPosition(), hitbox.GetSize() };
-    auto [grounded, touchingCeiling, touchingWall, touchingWallDirection, moveDelta] = game.level.collisionDetection(currentHitbox, velocity);
+    raylib::Rectangle currentHitbox = { motion.position - origin + physics.hitbox.GetPosition(), physics.hitbox.GetSize() };
+
+    // Moving platforms push the player out, and carry the player standing on them.
+    auto [pushOut, carryVelocity] = level.dynamicColliderResponse(currentHitbox);
+    motion.position += pushOut + carryVelocity * timeDelta;
+    currentHitbox.SetPosition(currentHitbox.GetPosition() + pushOut + carryVelocity * timeDelta);
+
+    auto [grounded, touchingCeiling, touchingWall, touchingWallDirection, moveDelta] = level.collisionDetection(currentHitbox, motion.velocity);
     if (grounded || touchingCeiling) {
-        velocity.y = 0.0f;
+        motion.velocity.y = 0.0f;
     }
     if (touchingWall) {
-        if ((velocity.x > 0) && (touchingWallDirection == 1))
-            velocity.x = 0.0f;
-        if ((velocity.x < 0) && (touchingWallDirection == -1))
-            velocity.x = 0.0f;
+        if ((motion.velocity.x > 0) && (touchingWallDirection == 1))
+            motion.velocity.x = 0.0f;
+        if ((motion.velocity.x < 0) && (touchingWallDirection == -1))
+            motion.velocity.x = 0.0f;
     }
 
+    auto& state = motion.state;
     auto oldState = state;
     if (grounded) {
         state = PlayerState::GROUNDED;
@@ -111,13 +111,13 @@ void Player::step(float timeDelta) {
         }
         if (touchingWall && buttonGrab) {
             state = PlayerState::GRABBING;
-            grabDirection = touchingWallDirection;
-            facingDirection = -touchingWallDirection;
+            motion.grabDirection = touchingWallDirection;
+            motion.facingDirection = -touchingWallDirection;
         }
-        if (touchingWall && buttonJump && !jumpButtonOwned) {
+        if (touchingWall && buttonJump && !motion.jumpButtonOwned) {
             state = PlayerState::WALL_KICK;
-            wallKickDirection = -touchingWallDirection;
-            facingDirection = -touchingWallDirection;
+            motion.wallKickDirection = -touchingWallDirection;
+            motion.facingDirection = -touchingWallDirection;
         }
     }
 
@@ -131,19 +131,19 @@ void Player::step(float timeDelta) {
 
     if (state == PlayerState::JUMPING) {
         if (oldState != state) {
-            jumpSfx.Play();
-            jumpStartTime = game.levelTime;
-            jumpButtonOwned = true;
-            if (std::signbit(static_cast<float>(axisX)) != std::signbit(velocity.x)) {
-                velocity.x *= jumpBackPenalty;
+            events.jumped = true;
+            motion.jumpStartTime = time;
+            motion.jumpButtonOwned = true;
+            if (std::signbit(static_cast<float>(axisX)) != std::signbit(motion.velocity.x)) {
+                motion.velocity.x *= physics.jumpBackPenalty;
             }
         }
-        if (buttonJump && (game.levelTime <= jumpStartTime + jumpAccelerationTime)) {
-            auto jumpTime = game.levelTime - jumpStartTime;
-            velocity.y = -jumpVelocity;
-            velocity.y += jumpSustainGravity * jumpTime * jumpTime;
+        if (buttonJump && (time <= motion.jumpStartTime + physics.jumpAccelerationTime)) {
+            auto jumpTime = time - motion.jumpStartTime;
+            motion.velocity.y = -physics.jumpVelocity;
+            motion.velocity.y += physics.jumpSustainGravity * jumpTime * jumpTime;
         } else {
-            jumpButtonBlocked = true;
+            motion.jumpButtonBlocked = true;
             state = PlayerState::FALLING;
             if (buttonGlide) {
                 state = PlayerState::GLIDING;
@@ -155,19 +155,19 @@ void Player::step(float timeDelta) {
 
     if (state == PlayerState::WALL_KICK) {
         if (oldState != state) {
-            jumpSfx.Play();
-            jumpStartTime = game.levelTime;
-            jumpButtonOwned = true;
+            events.jumped = true;
+            motion.jumpStartTime = time;
+            motion.jumpButtonOwned = true;
         }
-        if (buttonJump && (game.levelTime <= jumpStartTime + wallKickAccelerationTime)) {
-            auto jumpTime = game.levelTime - jumpStartTime;
-            velocity.y = -wallKickVelocity.y;
-            velocity.y += wallKickSustainGravity.y * jumpTime * jumpTime;
-            velocity.x = wallKickVelocity.x * wallKickDirection;
-            velocity.x += wallKickSustainGravity.x * wallKickDirection * jumpTime * jumpTime;
+        if (buttonJump && (time <= motion.jumpStartTime + physics.wallKickAccelerationTime)) {
+            auto jumpTime = time - motion.jumpStartTime;
+            motion.velocity.y = -physics.wallKickVelocity.y;
+            motion.velocity.y += physics.wallKickSustainGravity.y * jumpTime * jumpTime;
+            motion.velocity.x = physics.wallKickVelocity.x * motion.wallKickDirection;
+            motion.velocity.x += physics.wallKickSustainGravity.x * motion.wallKickDirection * jumpTime * jumpTime;
         }
         else {
-            jumpButtonBlocked = true;
+            motion.jumpButtonBlocked = true;
             state = PlayerState::FALLING;
             if (buttonGlide) {
                 state = PlayerState::GLIDING;
@@ -178,47 +178,75 @@ void Player::step(float timeDelta) {
     if ((state == PlayerState::JUMPING) || (state == PlayerState::FALLING) || (state == PlayerState::GLIDING) || ((state == PlayerState::WALL_KICK) && !startedWallKick)) {
         if (touchingWall && buttonGrab) {
             state = PlayerState::GRABBING;
-            facingDirection = -touchingWallDirection;
+            motion.facingDirection = -touchingWallDirection;
         }
     }
 
     if ((state == PlayerState::JUMPING) || (state == PlayerState::FALLING)) {
-        velocity.x += axisX * airCorrectionAcceleration * timeDelta;
+        motion.velocity.x += axisX * physics.airCorrectionAcceleration * timeDelta;
         if (axisX != 0) {
-            facingDirection = axisX;
+            motion.facingDirection = axisX;
         }
     }
     else
     if (state == PlayerState::GROUNDED) {
         if (axisX != 0) {
-            if (std::signbit(static_cast<float>(axisX)) == std::signbit(velocity.x))
-                velocity.x += axisX * landAcceleration * timeDelta;
+            if (std::signbit(static_cast<float>(axisX)) == std::signbit(motion.velocity.x))
+                motion.velocity.x += axisX * physics.landAcceleration * timeDelta;
             else
-                velocity.x += axisX * landHardDeceleration * timeDelta;
-            facingDirection = axisX;
+                motion.velocity.x += axisX * physics.landHardDeceleration * timeDelta;
+            motion.facingDirection = axisX;
         }
         else
-            if (velocity.x > 0)
-                velocity.x = std::max(0.0f, velocity.x - landDeceleration * timeDelta);
+            if (motion.velocity.x > 0)
+                motion.velocity.x = std::max(0.0f, motion.velocity.x - physics.landDeceleration * timeDelta);
             else
-                velocity.x = std::min(0.0f, velocity.x + landDeceleration * timeDelta);
+                motion.velocity.x = std::min(0.0f, motion.velocity.x + physics.landDeceleration * timeDelta);
     }
 
     if (state == PlayerState::FALLING) {
-        velocity.y += gravity * timeDelta;
+        motion.velocity.y += physics.gravity * timeDelta;
     }
     else
     if (state == PlayerState::GLIDING) {
-        velocity.y += glidingGravity * timeDelta;
+        motion.velocity.y += physics.glidingGravity * timeDelta;
     }
 
     if ((oldState != state) && (state == PlayerState::GROUNDED)) {
-        groundSfx.Play();
+        events.landed = true;
+    }
+
+    if (motion.velocity.x > 0) motion.velocity.x = std::min(motion.velocity.x, physics.landMaxSpeed);
+    if (motion.velocity.x < 0) motion.velocity.x = std::max(motion.velocity.x, -physics.landMaxSpeed);
+    motion.position += motion.velocity * timeDelta;
+
+    return events;
+}
+
+void Player::step(float timeDelta) {
+    PlayerInput input;
+    if (game.isInputDown(InputButton::RIGHT)) {
+        input.axisX += 1;
+    }
+    if (game.isInputDown(InputButton::LEFT)) {
+        input.axisX -= 1;
     }
+    input.jump = game.isInputDown(InputButton::JUMP) && !game.waitUntilJumpNotPressed; // A
+
+    auto [origin, image, sound] = runAnimation.spriteForTime(animation.getTime()); // @todo Using anim for hitbox is broken here.
+    auto events = stepPlayerPhysics(physics, *this, input, game.level, origin, game.levelTime, timeDelta);
+
+    if (events.jumpBlocked)
+        DrawText("JUMP BLOCKED", 10, 60, 10, BLACK);
+    if (events.jumpHeld)
+        DrawText("JUMP HELD", 10, 60, 10, BLACK);
+    if (events.jumpHeldArtificially)
+        DrawText("JUMP HELD ARTIFICIALLY", 10, 50, 10, BLACK);
 
-    if (velocity.x > 0) velocity.x = std::min(velocity.x, landMaxSpeed);
-    if (velocity.x < 0) velocity.x = std::max(velocity.x, -landMaxSpeed);
-    position += velocity * timeDelta;
+    if (events.jumped)
+        game.soundService.play(jumpSfx);
+    if (events.landed)
+        game.soundService.play(groundSfx);
 
     switch (state) {
         case PlayerState::GROUNDED: currentAnimation = (std::fabs(velocity.x) > 0.1f) ? &runAnimation : &idleAnimation; break;
@@ -231,23 +259,42 @@ void Player::step(float timeDelta) {
 }
 
 void Player::draw() {
+    auto isCulled = [&](const AnimationClip& clip) {
+        auto bounds = clip.getBounds(position);
+        if (facingDirection == -1)
+            bounds.x = 2.0f * position.x - (bounds.x + bounds.width); // Mirrored around position.
+        return game.cull(bounds);
+    };
+
     if (playerDead) {
-        if (!playerHide) {
-            auto [origin, image, sound] = actuallyDead ? hurtAnimation.spriteForTime(animTime) : idleAnimation.spriteForTime(animTime);
-            if (sound)
-                sound->Play();
-            game.drawSprite(position, image, origin, facingDirection == -1);
+        auto& deadAnimation = actuallyDead ? hurtAnimation : idleAnimation;
+        if (!playerHide && !isCulled(deadAnimation)) {
+            animation.play(deadAnimation);
+            playAnimationSound();
+            game.drawSprite(position, animation.getSprite(), animation.getOrigin(), facingDirection == -1, SpriteLayer::PLAYER);
         }
         return;
     }
 
-    auto [origin, image, sound] = currentAnimation->spriteForTime(animTime);
-    if (sound)
-        sound->Play();
-    game.drawSprite(position, image, origin, facingDirection == -1);
+    if (isCulled(*currentAnimation))
+        return;
+
+    animation.play(*currentAnimation);
+    playAnimationSound();
+    game.drawSprite(position, animation.getSprite(), animation.getOrigin(), facingDirection == -1, SpriteLayer::PLAYER);
+
+    auto hitBoxPosition = game.worldToScreen(position - animation.getOrigin() + physics.hitbox.GetPosition());
+    //DrawRectangleLines(hitBoxPosition.x, hitBoxPosition.y, physics.hitbox.GetWidth(), physics.hitbox.GetHeight(), RED);
+}
+
+void Player::playAnimationSound() {
+    if (auto sound = animation.takeSound(); sound != noSound)
+        game.soundService.play(sound, position);
+}
 
-    auto hitBoxPosition = game.worldToScreen(position - origin + hitbox.GetPosition());
-    //DrawRectangleLines(hitBoxPosition.x, hitBoxPosition.y, hitbox.GetWidth(), hitbox.GetHeight(), RED);
+raylib::Rectangle Player::getWorldHitbox() {
+    auto [origin, image, sound] = runAnimation.spriteForTime(animation.getTime()); // Same as in step().
+    return { position - origin + physics.hitbox.GetPosition(), physics.hitbox.GetSize() };
 }
 
 void Player::load() {
@@ -258,24 +305,24 @@ void Player::load() {
     auto json = nlohmann::json::parse(jsonText);
     auto basePath = std::filesystem::path(playerFile).parent_path();
 
-    landMaxSpeed = json["landMaxSpeed"].get<float>();
-    landAcceleration = json["landAcceleration"].get<float>();
-    landDeceleration = json["landDeceleration"].get<float>();
-    landHardDeceleration = json["landHardDeceleration"].get<float>();
-    airCorrectionAcceleration = json["airCorrectionAcceleration"].get<float>();
-
-    jumpVelocity = json["jumpVelocity"].get<float>();
-    jumpAccelerationTime = json["jumpAccelerationTime"].get<float>();
-    wallKickVelocity = raylib::Vector2{ json["wallKickVelocity"]["x"].get<float>(), json["wallKickVelocity"]["y"].get<float>() };
-    wallKickAccelerationTime = json["wallKickAccelerationTime"].get<float>();
-    jumpBackPenalty = json["jumpBackPenalty"].get<float>();
-
-    gravity = json["gravity"].get<float>();
-    glidingGravity = json["glidingGravity"].get<float>();
-    jumpSustainGravity = json["jumpSustainGravity"].get<float>();
-    wallKickSustainGravity = raylib::Vector2{ json["wallKickSustainGravity"]["x"].get<float>(), json["wallKickSustainGravity"]["y"].get<float>() };
-    jumpButtonActiveTime = json["jumpButtonActiveTime"].get<float>();
-    hitbox = raylib::Rectangle{ json["hitbox"]["x"].get<float>(), json["hitbox"]["y"].get<float>(), json["hitbox"]["width"].get<float>(), json["hitbox"]["height"].get<float>() };
+    physics.landMaxSpeed = json["landMaxSpeed"].get<float>();
+    physics.landAcceleration = json["landAcceleration"].get<float>();
+    physics.landDeceleration = json["landDeceleration"].get<float>();
+    physics.landHardDeceleration = json["landHardDeceleration"].get<float>();
+    physics.airCorrectionAcceleration = json["airCorrectionAcceleration"].get<float>();
+
+    physics.jumpVelocity = json["jumpVelocity"].get<float>();
+    physics.jumpAccelerationTime = json["jumpAccelerationTime"].get<float>();
+    physics.wallKickVelocity = raylib::Vector2{ json["wallKickVelocity"]["x"].get<float>(), json["wallKickVelocity"]["y"].get<float>() };
+    physics.wallKickAccelerationTime = json["wallKickAccelerationTime"].get<float>();
+    physics.jumpBackPenalty = json["jumpBackPenalty"].get<float>();
+
+    physics.gravity = json["gravity"].get<float>();
+    physics.glidingGravity = json["glidingGravity"].get<float>();
+    physics.jumpSustainGravity = json["jumpSustainGravity"].get<float>();
+    physics.wallKickSustainGravity = raylib::Vector2{ json["wallKickSustainGravity"]["x"].get<float>(), json["wallKickSustainGravity"]["y"].get<float>() };
+    physics.jumpButtonActiveTime = json["jumpButtonActiveTime"].get<float>();
+    physics.hitbox = raylib::Rectangle{ json["hitbox"]["x"].get<float>(), json["hitbox"]["y"].get<float>(), json["hitbox"]["width"].get<float>(), json["hitbox"]["height"].get<float>() };
 
     cameraWindow = loadJsonRect(json["cameraWindow"]);
 }
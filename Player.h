@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Animation.h"
+#include "SoundService.h"
 
 
 #include "raylib-cpp.hpp"
@@ -8,6 +9,7 @@
 
 
 class Game;
+class Level;
 
 
 enum class PlayerState {
@@ -31,27 +33,9 @@ inline std::string to_string(PlayerState state) {
     ZASSERT(false);
 }
 
-class Player {
-private:
-    Game& game;
-
-public:
-    PlayerState state = PlayerState::GROUNDED;
-    raylib::Vector2 position = { 0.0f, 0.0f };
-    raylib::Vector2 velocity = { 0.0f, 0.0f };
-    int facingDirection = 1;          ///< Player direction: 1 - right, -1 - left. Usually same as velocity.x, but sometimes not (when player is reversing, for example).
-
-    float animTime = 0.0f; ///< Time for current animation.
-    Animation* currentAnimation = &idleAnimation;
-    Animation idleAnimation;
-    Animation runAnimation;
-    Animation jumpUpAnimation;
-    Animation jumpDownAnimation;
-    Animation hurtAnimation;
-    Animation slideAnimation;
-    Animation glideAnimation;
-    Animation grabAnimation;
-
+/// Movement tuning of the player, loaded from player.json.
+/// Plain values, so LevelGenerator can copy them to validate levels on a worker thread.
+struct PlayerPhysics {
     float landMaxSpeed;                     ///< Max speed on land (pixels per second).
     float landAcceleration;                 ///< Land acceleration (pixels per second).
     float landDeceleration;                 ///< Land deceleration (pixels per second). Drag when player is not accelerating.
@@ -69,8 +53,23 @@ public:
     float jumpSustainGravity;               ///< Gravity applied during jumpAccelerationTime.
     raylib::Vector2 wallKickSustainGravity; ///< Gravity and deceleration applied during wallKickAccelerationTime.
     float jumpButtonActiveTime;             ///< Jump button is considered pressed for this amount of time after initial press (even if not held any more).
-    raylib::Rectangle hitbox;               ///< Hitbox of the player.
-    raylib::Rectangle cameraWindow;         ///< Fractions of the screen palyer must be in, unless level border doesn't allow it. @todo Should be in Game, but no time...
+    raylib::Rectangle hitbox;               ///< Hitbox of the player, relative to the sprite origin.
+};
+
+/// Buttons held during a physics step.
+struct PlayerInput {
+    int axisX = 0;                          ///< 1 is right, -1 is left.
+    bool jump = false;
+    bool grab = false;
+    bool glide = false;
+};
+
+/// Movement state of the player, advanced by stepPlayerPhysics().
+struct PlayerMotion {
+    PlayerState state = PlayerState::GROUNDED;
+    raylib::Vector2 position = { 0.0f, 0.0f };
+    raylib::Vector2 velocity = { 0.0f, 0.0f };
+    int facingDirection = 1;          ///< Player direction: 1 - right, -1 - left. Usually same as velocity.x, but sometimes not (when player is reversing, for example).
 
     float jumpButtonLastPressTime = -10.0f; ///< Time when user last pressed jump button.
     float jumpStartTime = -10.0f;           ///< Time when user started jumping/wall_kicking.
@@ -80,13 +79,51 @@ public:
 
     bool jumpButtonBlocked = false;         ///< Used to disable reacting to a held jump button.
     bool jumpButtonOwned = false;           ///< Used to mark that this press of jump button was already "used". Different from jumpButtonBlocked because of jumpButtonActiveTime. @todo Maybe clean up.
+};
+
+/// What happened during a physics step.
+struct PlayerStepEvents {
+    bool jumped = false;                    ///< Started a jump or a wall kick.
+    bool landed = false;
+    bool jumpBlocked = false;               ///< Jump button is held, but ignored. For the debug overlay.
+    bool jumpHeld = false;                  ///< Jump button is held. For the debug overlay.
+    bool jumpHeldArtificially = false;      ///< Jump button counts as held because of jumpButtonActiveTime. For the debug overlay.
+};
+
+/// Moves the player by one physics step, colliding with tiles and dynamic colliders of the level.
+/// Used by Player::step, and by LevelGenerator to validate generated levels, so both always follow the same rules.
+/// @param origin   Origin of the player sprite, which the hitbox is relative to.
+/// @param time     Level time of the step.
+PlayerStepEvents stepPlayerPhysics(const PlayerPhysics& physics, PlayerMotion& motion, const PlayerInput& input, Level& level, raylib::Vector2 origin, float time, float timeDelta);
+
+
+class Player : public PlayerMotion {
+private:
+    Game& game;
+
+public:
+    static constexpr int physicsSteps = 20;  ///< Physics steps per frame.
+
+    AnimationPlayer animation;                      ///< Plays currentAnimation.
+    const AnimationClip* currentAnimation = &idleAnimation;
+    AnimationClip idleAnimation;
+    AnimationClip runAnimation;
+    AnimationClip jumpUpAnimation;
+    AnimationClip jumpDownAnimation;
+    AnimationClip hurtAnimation;
+    AnimationClip slideAnimation;
+    AnimationClip glideAnimation;
+    AnimationClip grabAnimation;
+
+    PlayerPhysics physics;
+    raylib::Rectangle cameraWindow;         ///< Fractions of the screen palyer must be in, unless level border doesn't allow it. @todo Should be in Game, but no time...
 
     bool playerDead = false;
     bool actuallyDead = false;
     bool playerHide = false;
 
-    raylib::Sound jumpSfx;
-    raylib::Sound groundSfx;
+    SoundId jumpSfx;
+    SoundId groundSfx;
 
 public:
     Player(Game& game);
@@ -96,7 +133,7 @@ public:
         position = initialPosition;
         velocity = raylib::Vector2::Zero();
         facingDirection = 1;
-        animTime = 0.0f;
+        animation = AnimationPlayer();
         currentAnimation = &idleAnimation;
 
         jumpButtonLastPressTime = -10.0f;
@@ -115,8 +152,15 @@ public:
 
     void setPlayerDead(bool dead);
 
+    /// @returns Hitbox in world coordinates.
+    raylib::Rectangle getWorldHitbox();
+
     void update();
     void step(float timeDelta);
     void draw();
     void load();
+
+private:
+    /// Plays sound of the frame the animation just entered, if any.
+    void playAnimationSound();
 };
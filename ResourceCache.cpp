@@ -1,21 +1,576 @@
-
 #include "ResourceCache.h"
 
+#include "FileSystem.h"
+
+#include "zstr.h"
+#include "zerrors.h"
+
+#include <algorithm>
+#include <random>
+
+
+ResourceHandle::ResourceHandle(ResourceCache& cache, ResourceEntry& entry)
+    : cache(&cache)
+    , entry(&entry)
+{
+    ++entry.refCount;
+    entry.lastUsed = cache.nextUse();
+}
+
+ResourceHandle::ResourceHandle(const ResourceHandle& other)
+    : cache(other.cache)
+    , entry(other.entry)
+{
+    if (entry)
+        ++entry->refCount;
+}
+
+ResourceHandle::ResourceHandle(ResourceHandle&& other) noexcept
+    : cache(other.cache)
+    , entry(other.entry)
+{
+    other.cache = nullptr;
+    other.entry = nullptr;
+}
+
+ResourceHandle& ResourceHandle::operator=(const ResourceHandle& other) {
+    if (other.entry)
+        ++other.entry->refCount; // First, in case it's the same entry.
+    reset();
+    cache = other.cache;
+    entry = other.entry;
+    return *this;
+}
+
+ResourceHandle& ResourceHandle::operator=(ResourceHandle&& other) noexcept {
+    if (this != &other) {
+        reset();
+        cache = other.cache;
+        entry = other.entry;
+        other.cache = nullptr;
+        other.entry = nullptr;
+    }
+    return *this;
+}
+
+void ResourceHandle::reset() {
+    if (entry)
+        cache->release(*entry);
+    cache = nullptr;
+    entry = nullptr;
+}
+
+
+ResourceCache::ResourceCache() {
+#if !defined(PLATFORM_WEB) // We don't build with pthreads on the Web.
+    loaderThread = std::thread([this]() { loaderLoop(); });
+#endif
+}
+
+ResourceCache::~ResourceCache() {
+    if (loaderThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(loadMutex);
+            quitting = true;
+        }
+        loadRequested.notify_all();
+        loaderThread.join();
+    }
+    requests.clear();
+    decoded.clear();
+
+    // Sprites hold handles to atlas pages and images, so they must go first.
+    spriteCache.clear();
+    atlasPages.clear();
+    imageCache.clear();
+    soundCache.clear();
+}
+
+void ResourceCache::add(ResourceEntry& entry) {
+    ramBytes += entry.ramBytes;
+    vramBytes += entry.vramBytes;
+}
+
+void ResourceCache::release(ResourceEntry& entry) {
+    ZASSERT(entry.refCount > 0);
+    --entry.refCount;
+    entry.lastUsed = nextUse();
+    if (entry.refCount == 0)
+        mayEvict = true;
+}
+
+template<typename Entry>
+std::unique_ptr<Entry>& ResourceCache::slot(std::vector<std::unique_ptr<Entry>>& cache, ResourceId id) {
+    ZASSERT(id >= 0) << "Invalid resource id: " << id;
+    if (id >= std::ssize(cache))
+        cache.resize(id + 1);
+    return cache[id];
+}
+
+template<typename Entry>
+Entry& ResourceCache::createEntry(std::vector<std::unique_ptr<Entry>>& cache, ResourceId id, ResourceKind kind) {
+    auto& entry = slot(cache, id);
+    ZASSERT(!entry);
+    entry = std::make_unique<Entry>(paths.getPath(id), kind);
+    entry->id = id;
+    ++entryCount;
+    return *entry;
+}
+
+raylib::Texture2D* ResourceCache::getImage(ResourceId id, ResourceHandle& handle, int group) {
+    auto* entry = slot(imageCache, id).get();
+    if (!entry) {
+        entry = &createEntry(imageCache, id, ResourceKind::IMAGE);
+        entry->sprite = Sprite{ &entry->texture, { 0.0f, 0.0f, 0.0f, 0.0f } };
+        requestLoad(*entry, ResourceKind::IMAGE, group);
+    }
+
+    if (entry->loading && (group == loadNow))
+        waitUntil([&]() { return !entry->loading; });
+
+    handle = ResourceHandle(*this, *entry);
+    return &entry->texture;
+}
+
+raylib::Sound* ResourceCache::getSound(ResourceId id, ResourceHandle& handle, int group) {
+    auto* entry = slot(soundCache, id).get();
+    if (!entry) {
+        entry = &createEntry(soundCache, id, ResourceKind::SOUND);
+        requestLoad(*entry, ResourceKind::SOUND, group);
+    }
+
+    if (entry->loading && (group == loadNow))
+        waitUntil([&]() { return !entry->loading; });
+
+    handle = ResourceHandle(*this, *entry);
+    return &entry->sound;
+}
+
+const Sprite& ResourceCache::getImageSprite(ResourceId id, ResourceHandle& handle, int group) {
+    getImage(id, handle, group);
+    return imageCache[id]->sprite;
+}
+
+const Sprite& ResourceCache::getSprite(ResourceId id, ResourceHandle& handle, int group) {
+    auto* entry = slot(spriteCache, id).get();
+    if (!entry) {
+        entry = &createEntry(spriteCache, id, ResourceKind::SPRITE);
+        entry->sprite = emptySprite;
+        requestLoad(*entry, ResourceKind::SPRITE, group);
+    }
+
+    if (entry->loading && (group == loadNow))
+        waitUntil([&]() { return !entry->loading; });
+
+    handle = ResourceHandle(*this, *entry);
+    return entry->sprite;
+}
+
+void ResourceCache::requestLoad(ResourceEntry& entry, ResourceKind kind, int group) {
+    entry.loading = true;
+    ++pendingLoads[group];
+
+    auto request = std::make_unique<LoadRequest>();
+    request->entry = &entry;
+    request->fileName = entry.name;
+    request->kind = kind;
+    request->group = group;
+
+    if (group == loadNow) {
+        // Caller waits for it anyway, so don't bother the loader thread.
+        auto startTime = GetTime();
+        decode(*request);
+        finish(*request);
+        stalledThisFrame = true;
+        stallTime += GetTime() - startTime;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        requests.push_back(std::move(request));
+    }
+    loadRequested.notify_one();
+}
+
+void ResourceCache::loaderLoop() {
+    while (true) {
+        std::unique_ptr<LoadRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(loadMutex);
+            loadRequested.wait(lock, [this]() { return quitting || !requests.empty(); });
+            if (quitting)
+                return;
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        decode(*request);
+
+        {
+            std::lock_guard<std::mutex> lock(loadMutex);
+            decoded.push_back(std::move(request));
+        }
+        loadDecoded.notify_all();
+    }
+}
+
+void ResourceCache::decode(LoadRequest& request) {
+    try {
+        if (request.kind == ResourceKind::SOUND)
+            request.wave = loadWaveFile(request.fileName);
+        else
+            request.image = loadImageFile(request.fileName);
+    }
+    catch (...) {
+        request.error = std::current_exception();
+    }
+}
+
+void ResourceCache::finish(LoadRequest& request) {
+    auto group = pendingLoads.find(request.group);
+    ZASSERT(group != pendingLoads.end());
+    if (--group->second == 0)
+        pendingLoads.erase(group);
+
+    auto& entry = *request.entry;
+    entry.loading = false;
+    if (request.error)
+        std::rethrow_exception(request.error);
+
+    switch (request.kind) {
+        case ResourceKind::IMAGE:
+            finishImage(static_cast<ImageEntry&>(entry), request.image);
+            break;
+        case ResourceKind::SPRITE:
+            finishSprite(static_cast<SpriteEntry&>(entry), request.image);
+            break;
+        case ResourceKind::SOUND: {
+            auto& soundEntry = static_cast<SoundEntry&>(entry);
+            soundEntry.sound.Load(request.wave);
+            soundEntry.ramBytes = static_cast<size_t>(soundEntry.sound.frameCount) * soundEntry.sound.stream.channels * soundEntry.sound.stream.sampleSize / 8;
+            add(soundEntry);
+            break;
+        }
+        case ResourceKind::ATLAS_PAGE:
+            ZASSERT(false) << "Atlas pages aren't loaded.";
+    }
+}
+
+void ResourceCache::finishImage(ImageEntry& entry, const raylib::Image& image) {
+    entry.texture.Load(image);
+    entry.sprite = Sprite{ &entry.texture, raylib::Rectangle{ raylib::Vector2::Zero(), entry.texture.GetSize() } };
+    entry.vramBytes = GetPixelDataSize(entry.texture.width, entry.texture.height, entry.texture.format);
+    add(entry);
+}
+
+void ResourceCache::finishSprite(SpriteEntry& entry, const raylib::Image& image) {
+    auto width = image.GetWidth();
+    auto height = image.GetHeight();
+
+    if ((width + atlasPadding > atlasSize) || (height + atlasPadding > atlasSize)) {
+        if (!slot(imageCache, entry.id))
+            finishImage(createEntry(imageCache, entry.id, ResourceKind::IMAGE), image);
+        entry.sprite = getImageSprite(entry.id, entry.owner);
+        return;
+    }
+
+    auto fits = [&](const AtlasPage& page) {
+        if (page.shelfX + width + atlasPadding <= atlasSize)
+            return page.shelfY + height + atlasPadding <= atlasSize;
+        return page.shelfY + page.shelfHeight + height + atlasPadding <= atlasSize;
+    };
+
+    // First page with space left. Pages are only filled from the end of their last shelf.
+    auto pageIt = std::find_if(atlasPages.begin(), atlasPages.end(), [&](const auto& page) { return fits(*page); });
+    if (pageIt == atlasPages.end()) {
+        ++atlasPagesCreated;
+        auto page = std::make_unique<AtlasPage>((ZSTR() << "atlas page " << atlasPagesCreated).str(), ResourceKind::ATLAS_PAGE);
+        page->image = raylib::Image(atlasSize, atlasSize, BLANK);
+        page->texture = std::make_unique<raylib::Texture2D>(page->image);
+        page->ramBytes = GetPixelDataSize(atlasSize, atlasSize, page->image.format);
+        page->vramBytes = GetPixelDataSize(atlasSize, atlasSize, page->texture->format);
+        add(*page);
+        atlasPages.push_back(std::move(page));
+        ++entryCount;
+        TraceLog(LOG_INFO, (ZSTR() << "Created sprite atlas page " << atlasPagesCreated).str().c_str());
+        pageIt = std::prev(atlasPages.end());
+    }
+
+    auto& page = **pageIt;
+    if (page.shelfX + width + atlasPadding > atlasSize) {
+        page.shelfX = 0;
+        page.shelfY += page.shelfHeight;
+        page.shelfHeight = 0;
+    }
+
+    raylib::Rectangle destination{ static_cast<float>(page.shelfX + atlasPadding), static_cast<float>(page.shelfY + atlasPadding), static_cast<float>(width), static_cast<float>(height) };
+    page.image.Draw(image, raylib::Rectangle{ 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height) }, destination);
+    page.shelfX += width + atlasPadding;
+    page.shelfHeight = std::max(page.shelfHeight, height + atlasPadding);
+
+    auto top = page.shelfY + atlasPadding;
+    auto bottom = top + height;
+    if (page.dirtyTop == page.dirtyBottom) {
+        page.dirtyTop = top;
+        page.dirtyBottom = bottom;
+    }
+    else {
+        page.dirtyTop = std::min(page.dirtyTop, top);
+        page.dirtyBottom = std::max(page.dirtyBottom, bottom);
+    }
+
+    entry.sprite = Sprite{ page.texture.get(), destination };
+    entry.owner = ResourceHandle(*this, page);
+}
+
+void ResourceCache::waitUntil(const std::function<bool()>& done) {
+    auto startTime = GetTime();
+    while (!done()) {
+        std::unique_ptr<LoadRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(loadMutex);
+            if (loaderThread.joinable()) {
+                loadDecoded.wait(lock, [this]() { return !decoded.empty(); });
+                request = std::move(decoded.front());
+                decoded.pop_front();
+            }
+            else {
+                ZASSERT(!requests.empty()) << "Waiting for a load that was never requested.";
+                request = std::move(requests.front());
+                requests.pop_front();
+            }
+        }
+
+        if (!loaderThread.joinable())
+            decode(*request);
+        finish(*request);
+    }
+
+    stalledThisFrame = true;
+    stallTime += GetTime() - startTime;
+}
+
+void ResourceCache::waitForGroup(int group) {
+    waitUntil([&]() { return isGroupLoaded(group); });
+}
+
+int ResourceCache::getPendingLoadCount() const {
+    int count = 0;
+    for (const auto& [group, pending] : pendingLoads)
+        count += pending;
+    return count;
+}
+
+void ResourceCache::update() {
+    // Sprites are uploaded with their atlas pages, in updateAtlases(). Those uploads (including ones left by synchronous loads) count too.
+    size_t loadBytes = 0;
+    size_t uploadedBytes = 0;
+    while (uploadedBytes < uploadBytesPerFrame) {
+        std::unique_ptr<LoadRequest> request;
+        bool needsDecoding = false;
+        {
+            std::lock_guard<std::mutex> lock(loadMutex);
+            if (!decoded.empty()) {
+                request = std::move(decoded.front());
+                decoded.pop_front();
+            }
+            else if (!loaderThread.joinable() && !requests.empty()) {
+                request = std::move(requests.front());
+                requests.pop_front();
+                needsDecoding = true;
+            }
+        }
+        if (!request)
+            break;
+
+        if (needsDecoding)
+            decode(*request);
+        auto isAtlasSprite = (request->kind == ResourceKind::SPRITE) && (request->image.width + atlasPadding <= atlasSize) && (request->image.height + atlasPadding <= atlasSize);
+        if (request->kind == ResourceKind::SOUND)
+            loadBytes += static_cast<size_t>(request->wave.frameCount) * request->wave.channels * request->wave.sampleSize / 8;
+        else if (!isAtlasSprite)
+            loadBytes += static_cast<size_t>(request->image.width) * request->image.height * 4;
+        finish(*request);
+        uploadedBytes = loadBytes + getAtlasUploadBytes();
+    }
+
+    updateAtlases();
+    trim();
 
-raylib::Texture2D* ResourceCache::getImage(const std::string& fileName) {
-    auto it = imageCache.find(fileName);
-    if (it != imageCache.end())
-        return it->second.get();
+    if (stalledThisFrame)
+        ++stalledFrames;
+    lastFrameStallTime = stallTime;
+    stalledThisFrame = false;
+    stallTime = 0.0;
+}
+
+void ResourceCache::updateAtlases() {
+    for (auto& page : atlasPages) {
+        if (page->dirtyTop == page->dirtyBottom)
+            continue;
+        // Whole rows are contiguous in the image, so they upload straight from it.
+        auto rowBytes = GetPixelDataSize(atlasSize, 1, page->image.format);
+        raylib::Rectangle rows{ 0.0f, static_cast<float>(page->dirtyTop), static_cast<float>(atlasSize), static_cast<float>(page->dirtyBottom - page->dirtyTop) };
+        UpdateTextureRec(*page->texture, rows, static_cast<const unsigned char*>(page->image.data) + static_cast<size_t>(page->dirtyTop) * rowBytes);
+        page->dirtyTop = 0;
+        page->dirtyBottom = 0;
+    }
+}
+
+size_t ResourceCache::getAtlasUploadBytes() const {
+    size_t bytes = 0;
+    for (const auto& page : atlasPages)
+        bytes += static_cast<size_t>(page->dirtyBottom - page->dirtyTop) * GetPixelDataSize(atlasSize, 1, page->image.format);
+    return bytes;
+}
+
+template<typename Func>
+void ResourceCache::forEachEntry(Func func) const {
+    for (const auto& entry : imageCache) {
+        if (entry)
+            func(*entry);
+    }
+    for (const auto& entry : soundCache) {
+        if (entry)
+            func(*entry);
+    }
+    for (const auto& entry : spriteCache) {
+        if (entry)
+            func(*entry);
+    }
+    for (const auto& page : atlasPages)
+        func(*page);
+}
 
-    auto [newit, inserted] = imageCache.try_emplace(fileName, std::make_unique<raylib::Texture2D>(fileName));
-    return newit->second.get();
+void ResourceCache::trim() {
+    while (mayEvict && ((ramBytes > ramBudget) || (vramBytes > vramBudget))) {
+        ResourceEntry* oldest = nullptr;
+        forEachEntry([&](ResourceEntry& entry) {
+            if ((entry.refCount == 0) && !entry.loading && (!oldest || (entry.lastUsed < oldest->lastUsed)))
+                oldest = &entry;
+        });
+
+        if (!oldest) {
+            mayEvict = false; // Everything is in use, no point in looking again until something is released.
+            break;
+        }
+
+        evict(*oldest);
+    }
 }
 
-raylib::Sound* ResourceCache::getSound(const std::string& fileName) {
-    auto it = soundCache.find(fileName);
-    if (it != soundCache.end())
-        return it->second.get();
+void ResourceCache::evict(ResourceEntry& entry) {
+    ZASSERT(entry.refCount == 0);
+    TraceLog(LOG_INFO, (ZSTR() << "Evicting " << resourceKindName(entry.kind) << " " << entry.name << " (" << (entry.ramBytes + entry.vramBytes) / 1024 << " KB)").str().c_str());
+    ramBytes -= entry.ramBytes;
+    vramBytes -= entry.vramBytes;
+    ++evictionCount;
+
+    --entryCount;
+
+    // Entry is destroyed below.
+    switch (entry.kind) {
+        case ResourceKind::IMAGE: imageCache[entry.id].reset(); break;
+        case ResourceKind::SOUND: soundCache[entry.id].reset(); break;
+        case ResourceKind::SPRITE: spriteCache[entry.id].reset(); break; // Releases its atlas page.
+        case ResourceKind::ATLAS_PAGE:
+            std::erase_if(atlasPages, [&](const auto& page) { return page.get() == &entry; });
+            break;
+    }
+}
+
+void ResourceCache::evictUnused(std::vector<const ResourceEntry*> entries) {
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    // Sprites go first, because they hold their atlas pages and images. Evicting a sprite can leave its owner unused,
+    // so owners (which may be listed too) are evicted only after all sprites, and each of them only once.
+    std::vector<const ResourceEntry*> others;
+    for (auto entry : entries) {
+        if (entry->kind != ResourceKind::SPRITE) {
+            others.push_back(entry);
+            continue;
+        }
+        if ((entry->refCount != 0) || entry->loading)
+            continue;
+        if (auto owner = static_cast<const SpriteEntry*>(entry)->owner.getEntry())
+            others.push_back(owner);
+        evict(const_cast<ResourceEntry&>(*entry)); // Cache owns all entries.
+    }
+
+    // Atlas pages are shared, so they go only if all of their sprites are gone.
+    std::sort(others.begin(), others.end());
+    others.erase(std::unique(others.begin(), others.end()), others.end());
+    for (auto entry : others) {
+        if ((entry->refCount == 0) && !entry->loading)
+            evict(const_cast<ResourceEntry&>(*entry));
+    }
+}
+
+std::vector<const ResourceEntry*> ResourceCache::getTopConsumers(int count) const {
+    std::vector<const ResourceEntry*> entries;
+    forEachEntry([&](const ResourceEntry& entry) {
+        if (entry.ramBytes + entry.vramBytes > 0)
+            entries.push_back(&entry);
+    });
+
+    auto bytes = [](const ResourceEntry* entry) { return entry->ramBytes + entry->vramBytes; };
+    auto numEntries = std::min(static_cast<size_t>(std::max(count, 0)), entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + numEntries, entries.end(), [&](auto a, auto b) { return bytes(a) > bytes(b); });
+    entries.resize(numEntries);
+    return entries;
+}
+
+void ResourceCache::logReport(int count) const {
+    TraceLog(LOG_INFO, (ZSTR() << "Resource cache: " << getEntryCount() << " entries, RAM " << ramBytes / 1024 << " / " << ramBudget / 1024 << " KB, VRAM " << vramBytes / 1024 << " / " << vramBudget / 1024 << " KB, " << evictionCount << " evictions").str().c_str());
+    for (auto entry : getTopConsumers(count)) {
+        TraceLog(LOG_INFO, (ZSTR() << "    " << resourceKindName(entry->kind) << " " << entry->name << ": RAM " << entry->ramBytes / 1024 << " KB, VRAM " << entry->vramBytes / 1024 << " KB, " << entry->refCount << " handles").str().c_str());
+    }
+}
+
+void ResourceCache::benchmarkLookups(int iterations) const {
+    // Lookups by path, as they were done before paths were interned.
+    std::unordered_map<std::string, const ResourceEntry*> byPath;
+    std::vector<ResourceId> ids;
+    for (const auto& entry : spriteCache) {
+        if (!entry)
+            continue;
+        byPath.try_emplace(entry->name, entry.get());
+        ids.push_back(entry->id);
+    }
+    if (ids.empty())
+        return;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pick(0, static_cast<int>(std::ssize(ids)) - 1);
+    std::vector<ResourceId> lookups(iterations);
+    std::vector<std::string> pathLookups(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        lookups[i] = ids[pick(rng)];
+        pathLookups[i] = paths.getPath(lookups[i]);
+    }
+
+    size_t checksum = 0;
+    auto startTime = GetTime();
+    for (const auto& path : pathLookups)
+        checksum += byPath.find(path)->second->ramBytes + 1;
+    auto pathTime = GetTime() - startTime;
+
+    startTime = GetTime();
+    for (auto id : lookups)
+        checksum += spriteCache[id]->ramBytes + 1;
+    auto idTime = GetTime() - startTime;
+
+    TraceLog(LOG_INFO, (ZSTR() << "Resource lookup (" << std::ssize(ids) << " sprites, " << paths.getCount() << " paths): by path " << pathTime * 1000.0 << " ms, by id " << idTime * 1000.0 << " ms, " << iterations << " lookups (checksum " << checksum << ")").str().c_str());
+}
 
-    auto [newit, inserted] = soundCache.try_emplace(fileName, std::make_unique<raylib::Sound>(fileName));
-    return newit->second.get();
+const char* resourceKindName(ResourceKind kind) {
+    switch (kind) {
+        case ResourceKind::IMAGE: return "image";
+        case ResourceKind::SOUND: return "sound";
+        case ResourceKind::SPRITE: return "sprite";
+        case ResourceKind::ATLAS_PAGE: return "atlas";
+    }
+    ZASSERT(false);
 }
@@ -1,20 +1,266 @@
 #pragma once
 
+#include "PathInterner.h"
+
 #include "raylib-cpp.hpp"
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+
+
+class ResourceCache;
+
+/// Part of a texture. Most sprites are in an atlas texture shared with other sprites.
+struct Sprite {
+    raylib::Texture2D* texture = nullptr;
+    raylib::Rectangle source = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    raylib::Vector2 GetSize() const { return source.GetSize(); }
+};
+
+enum class ResourceKind {
+    IMAGE,
+    SOUND,
+    SPRITE,         ///< Bytes are accounted in the atlas page (or image) holding the sprite.
+    ATLAS_PAGE,
+};
+
+/// Bookkeeping of a cached resource.
+struct ResourceEntry {
+    std::string name;
+    ResourceKind kind;
+    ResourceId id = invalidResourceId;  ///< Invalid for atlas pages.
+    size_t ramBytes = 0;
+    size_t vramBytes = 0;
+    int refCount = 0;           ///< Number of ResourceHandles. Only entries with zero can be evicted.
+    uint64_t lastUsed = 0;      ///< When entry was last acquired or released. Bigger is more recent.
+    bool loading = false;       ///< True while loaded asynchronously. Resource is a placeholder until then.
+
+    ResourceEntry(std::string name, ResourceKind kind) : name(std::move(name)), kind(kind) {}
+    virtual ~ResourceEntry() = default;
+};
+
+/// Keeps a cached resource from being evicted, as long as the handle (or any copy of it) exists.
+class ResourceHandle {
+private:
+    ResourceCache* cache = nullptr;
+    ResourceEntry* entry = nullptr;
 
+public:
+    ResourceHandle() = default;
+    ResourceHandle(ResourceCache& cache, ResourceEntry& entry);
+    ResourceHandle(const ResourceHandle& other);
+    ResourceHandle(ResourceHandle&& other) noexcept;
+    ResourceHandle& operator=(const ResourceHandle& other);
+    ResourceHandle& operator=(ResourceHandle&& other) noexcept;
+    ~ResourceHandle() { reset(); }
+
+    void reset();
+
+    const ResourceEntry* getEntry() const { return entry; }
+    explicit operator bool() const { return entry != nullptr; }
+};
 
+/// Loads every file once, and shares it between all users.
+/// Users hold ResourceHandles. Entries without handles stay cached, until cache goes over its budget,
+/// then least recently used ones are evicted.
+/// Files can be loaded asynchronously: they are decoded on a loader thread, and uploaded on the main thread
+/// in update(), at most uploadBytesPerFrame per frame. Until then getters return placeholders (empty sprites, silent sounds).
 class ResourceCache
 {
 public:
+    static constexpr int atlasSize = 2048;      ///< Width and height of an atlas page.
+    static constexpr int atlasPadding = 2;      ///< Empty pixels between sprites in an atlas, so filtering doesn't bleed.
+    static constexpr int loadNow = -1;          ///< Load group for synchronous loads.
+    static constexpr size_t uploadBytesPerFrame = 16 * 1024 * 1024;   ///< How much async loads (and atlas updates) upload per frame (at least one load is always uploaded).
+
+#if defined(PLATFORM_WEB)
+    static constexpr size_t defaultRamBudget = 128 * 1024 * 1024;
+    static constexpr size_t defaultVramBudget = 256 * 1024 * 1024;
+#else
+    static constexpr size_t defaultRamBudget = 256 * 1024 * 1024;
+    static constexpr size_t defaultVramBudget = 512 * 1024 * 1024;
+#endif
+
+private:
+    friend class ResourceHandle;
+
+    struct ImageEntry : ResourceEntry {
+        raylib::Texture2D texture;
+        Sprite sprite;              ///< Whole texture.
+        using ResourceEntry::ResourceEntry;
+    };
+
+    struct SoundEntry : ResourceEntry {
+        raylib::Sound sound;
+        using ResourceEntry::ResourceEntry;
+    };
+
+    struct SpriteEntry : ResourceEntry {
+        Sprite sprite;
+        ResourceHandle owner;       ///< Atlas page (or image) holding the sprite.
+        using ResourceEntry::ResourceEntry;
+    };
+
+    /// Atlas texture. Sprites are placed in rows (shelves) from top to bottom.
+    /// Space of evicted sprites isn't reused, it is freed only when the whole page is evicted (after all of its sprites).
+    struct AtlasPage : ResourceEntry {
+        raylib::Image image;                        ///< Copy of texture on CPU side, where sprites are drawn.
+        std::unique_ptr<raylib::Texture2D> texture;
+        int shelfX = 0;                             ///< Where next sprite in current shelf goes.
+        int shelfY = 0;                             ///< Top of current shelf.
+        int shelfHeight = 0;                        ///< Height of the highest sprite in current shelf.
+        int dirtyTop = 0;                           ///< Rows [dirtyTop, dirtyBottom) of image changed since last upload to texture.
+        int dirtyBottom = 0;
+        using ResourceEntry::ResourceEntry;
+    };
+
+    /// Decoded on the loader thread, finished on the main thread.
+    struct LoadRequest {
+        ResourceEntry* entry;       ///< Only touched on the main thread.
+        std::string fileName;
+        ResourceKind kind;
+        int group;
+        raylib::Image image;
+        raylib::Wave wave;
+        std::exception_ptr error;   ///< Rethrown on the main thread.
+    };
+
     raylib::Texture2D emptyImage;
-    std::unordered_map<std::string, std::unique_ptr<raylib::Texture2D>> imageCache; ///< Cache of images, so that we only load once.
-    std::unordered_map<std::string, std::unique_ptr<raylib::Sound>> soundCache; ///< Cache of sounds, so that we only load once.
+    Sprite emptySprite = { &emptyImage, { 0.0f, 0.0f, 0.0f, 0.0f } };
+    PathInterner paths;
+    // Caches below are indexed by ResourceId, and have nullptr for resources that aren't cached.
+    std::vector<std::unique_ptr<ImageEntry>> imageCache;    ///< Cache of images, so that we only load once.
+    std::vector<std::unique_ptr<SoundEntry>> soundCache;    ///< Cache of sounds, so that we only load once.
+    std::vector<std::unique_ptr<SpriteEntry>> spriteCache;  ///< Cache of sprites, so that we only pack them once.
+    int entryCount = 0;                                     ///< Number of entries in all caches, including atlas pages.
+    std::vector<std::unique_ptr<AtlasPage>> atlasPages;
+    int atlasPagesCreated = 0;
+
+    size_t ramBudget = defaultRamBudget;
+    size_t vramBudget = defaultVramBudget;
+    size_t ramBytes = 0;
+    size_t vramBytes = 0;
+    uint64_t useCounter = 0;
+    bool mayEvict = false;      ///< False if last trim() found nothing to evict, and nothing was released since.
+    int evictionCount = 0;
+
+    std::thread loaderThread;                               ///< Not started on the Web, update() decodes there instead.
+    std::mutex loadMutex;
+    std::condition_variable loadRequested;
+    std::condition_variable loadDecoded;
+    std::deque<std::unique_ptr<LoadRequest>> requests;      ///< Waiting for decoding. Guarded by loadMutex.
+    std::deque<std::unique_ptr<LoadRequest>> decoded;       ///< Waiting for upload. Guarded by loadMutex.
+    bool quitting = false;                                  ///< Guarded by loadMutex.
+    std::unordered_map<int, int> pendingLoads;              ///< Number of unfinished loads in every group.
+
+    bool stalledThisFrame = false;
+    int stalledFrames = 0;              ///< Frames where the main thread waited for loading or decoding.
+    double lastFrameStallTime = 0.0;    ///< How long main thread waited during last frame (in seconds).
+    double stallTime = 0.0;
 
 public:
+    ResourceCache();
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator=(const ResourceCache&) = delete;
+    ~ResourceCache();
+
     raylib::Texture2D* getEmptyImage() { return &emptyImage; }
-    raylib::Texture2D* getImage(const std::string& fileName);
-    raylib::Sound* getSound(const std::string& fileName);
+    const Sprite& getEmptySprite() const { return emptySprite; }
+
+    /// Paths should be interned once, when loading, so that getters below don't touch strings.
+    ResourceId internPath(std::string_view path) { return paths.intern(path); }
+    ResourceId internPath(const std::filesystem::path& directory, std::string_view relativePath) { return paths.intern(directory, relativePath); }
+    const std::string& getPath(ResourceId id) const { return paths.getPath(id); }
+
+    /// Getters below set handle, so it keeps returned resource loaded.
+    /// Returned resources live in the cache, and are filled in when an async load finishes.
+    /// @param group    Load group for async loads, or loadNow to load synchronously.
+    ///                 Synchronous get of a resource that is still loading waits for it.
+    raylib::Texture2D* getImage(ResourceId id, ResourceHandle& handle, int group = loadNow);
+    raylib::Sound* getSound(ResourceId id, ResourceHandle& handle, int group = loadNow);
+
+    /// @returns Whole image as a sprite, in its own texture.
+    const Sprite& getImageSprite(ResourceId id, ResourceHandle& handle, int group = loadNow);
+
+    /// @returns Image packed into an atlas. Images too big for an atlas page get their own texture.
+    const Sprite& getSprite(ResourceId id, ResourceHandle& handle, int group = loadNow);
+
+    /// Finishes async loads (within the upload cap), uploads atlases and trims the cache. Call once per frame, before drawing.
+    void update();
+
+    /// Blocks until all loads in given group are finished. For loading screens.
+    void waitForGroup(int group);
+    bool isGroupLoaded(int group) const { return !pendingLoads.contains(group); }
+
+    /// Evicts least recently used entries without handles, until cache is within its budgets. Cheap if it already is.
+    void trim();
+    /// Evicts given entries if nothing uses them, with atlas pages (or images) that held them.
+    /// For big resources that won't be needed for a while, so they don't wait for the budget.
+    void evictUnused(std::vector<const ResourceEntry*> entries);
+
+    void setBudgets(size_t ramBudget, size_t vramBudget) { this->ramBudget = ramBudget; this->vramBudget = vramBudget; mayEvict = true; }
+
+    int getAtlasPageCount() const { return static_cast<int>(std::ssize(atlasPages)); }
+    int getEntryCount() const { return entryCount; }
+    int getEvictionCount() const { return evictionCount; }
+    int getStalledFrames() const { return stalledFrames; }
+    double getLastFrameStallTime() const { return lastFrameStallTime; }
+    int getPendingLoadCount() const;
+    size_t getRamBytes() const { return ramBytes; }
+    size_t getVramBytes() const { return vramBytes; }
+    size_t getRamBudget() const { return ramBudget; }
+    size_t getVramBudget() const { return vramBudget; }
+
+    /// @returns Entries using the most memory (RAM + VRAM), biggest first.
+    std::vector<const ResourceEntry*> getTopConsumers(int count) const;
+
+    /// Logs totals and top consumers.
+    void logReport(int count = 20) const;
+
+    /// Compares looking up cached resources by id with looking them up by path in a hash map (as we used to), and logs how long both took.
+    void benchmarkLookups(int iterations) const;
+
+private:
+    /// Uploads changed rows of atlas pages.
+    void updateAtlases();
+    /// @returns How much updateAtlases() will upload.
+    size_t getAtlasUploadBytes() const;
+
+    /// @returns Slot of given resource in given cache, growing the cache if needed.
+    template<typename Entry>
+    static std::unique_ptr<Entry>& slot(std::vector<std::unique_ptr<Entry>>& cache, ResourceId id);
+
+    template<typename Entry>
+    Entry& createEntry(std::vector<std::unique_ptr<Entry>>& cache, ResourceId id, ResourceKind kind);
+
+    void requestLoad(ResourceEntry& entry, ResourceKind kind, int group);
+    void loaderLoop();
+    static void decode(LoadRequest& request);
+    void finish(LoadRequest& request);
+    void finishImage(ImageEntry& entry, const raylib::Image& image);
+    void finishSprite(SpriteEntry& entry, const raylib::Image& image);
+
+    /// Finishes loads (decoding them here, if there is no loader thread) until done() returns true.
+    void waitUntil(const std::function<bool()>& done);
+
+    void add(ResourceEntry& entry);
+    void evict(ResourceEntry& entry);
+    void release(ResourceEntry& entry);
+    uint64_t nextUse() { return ++useCounter; }
+
+    template<typename Func>
+    void forEachEntry(Func func) const;
 };
+
+const char* resourceKindName(ResourceKind kind);
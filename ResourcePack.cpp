@@ -0,0 +1,43 @@
+#include "ResourcePack.h"
+
+#include "zerrors.h"
+
+#include <algorithm>
+
+
+bool ResourcePack::open(const std::string& fileName) {
+    close();
+    if (!file.open(fileName))
+        return false;
+
+    auto fileSize = file.getSize();
+    ZASSERT(fileSize >= sizeof(PackHeader)) << "Resource pack '" << fileName << "' is truncated.";
+    auto packHeader = reinterpret_cast<const PackHeader*>(file.getData());
+    ZASSERT(packHeader->magic == packMagic) << "'" << fileName << "' is not a resource pack.";
+    ZASSERT(packHeader->version == packVersion) << "Resource pack '" << fileName << "' has version " << packHeader->version << ", expected " << packVersion << ".";
+    ZASSERT(packHeader->indexOffset + packHeader->entryCount * sizeof(PackEntry) <= packHeader->namesOffset) << "Resource pack '" << fileName << "' has invalid index.";
+    ZASSERT(packHeader->namesOffset <= fileSize) << "Resource pack '" << fileName << "' is truncated.";
+
+    header = packHeader;
+    entries = reinterpret_cast<const PackEntry*>(file.getData() + header->indexOffset);
+    names = reinterpret_cast<const char*>(file.getData() + header->namesOffset);
+    return true;
+}
+
+void ResourcePack::close() {
+    file.close();
+    header = nullptr;
+    entries = nullptr;
+    names = nullptr;
+}
+
+const PackEntry* ResourcePack::find(std::string_view name) const {
+    if (!header)
+        return nullptr;
+
+    auto end = entries + header->entryCount;
+    auto it = std::lower_bound(entries, end, name, [this](const PackEntry& entry, std::string_view name) { return getName(entry) < name; });
+    if ((it == end) || (getName(*it) != name))
+        return nullptr;
+    return it;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+
+/// Resource pack file layout:
+///   PackHeader
+///   entry data, every entry aligned to packAlignment
+///   PackEntry index, sorted by name
+///   names (not null terminated)
+/// All numbers are little endian.
+
+constexpr uint32_t packMagic = 0x4B504A42;     ///< "BJPK"
+constexpr uint32_t packVersion = 1;
+constexpr uint32_t packAlignment = 16;
+
+struct PackHeader {
+    uint32_t magic = packMagic;
+    uint32_t version = packVersion;
+    uint32_t entryCount = 0;
+    uint32_t reserved = 0;
+    uint64_t indexOffset = 0;
+    uint64_t namesOffset = 0;
+};
+
+enum PackEntryFlags : uint32_t {
+    PACK_ENTRY_COMPRESSED = 1,      ///< Compressed with raylib's CompressData() (DEFLATE).
+};
+
+struct PackEntry {
+    uint64_t dataOffset;
+    uint32_t storedSize;    ///< Size in the pack.
+    uint32_t size;          ///< Size after decompression.
+    uint32_t nameOffset;    ///< Relative to PackHeader::namesOffset.
+    uint32_t nameLength;
+    uint32_t flags;         ///< PackEntryFlags.
+    uint32_t reserved;
+};
+
+/// Read-only resource pack, mapped into memory. Built by the pack tool (Tools/PackTool.cpp).
+/// Names are normalized paths relative to the Runtime directory, with forward slashes.
+class ResourcePack {
+private:
+    MappedFile file;
+    const PackHeader* header = nullptr;
+    const PackEntry* entries = nullptr;
+    const char* names = nullptr;
+
+public:
+    /// @returns False if there is no such file. Throws if it isn't a valid pack.
+    bool open(const std::string& fileName);
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    int getEntryCount() const { return header ? static_cast<int>(header->entryCount) : 0; }
+
+    /// @returns Entry with given normalized name, or nullptr.
+    const PackEntry* find(std::string_view name) const;
+
+    std::string_view getName(const PackEntry& entry) const { return { names + entry.nameOffset, entry.nameLength }; }
+
+    /// @returns Entry data as stored in the pack (compressed if entry is compressed). Valid while the pack is open.
+    std::span<const unsigned char> getStoredData(const PackEntry& entry) const { return { file.getData() + entry.dataOffset, entry.storedSize }; }
+};
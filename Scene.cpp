@@ -4,6 +4,7 @@
 #include "Game.h"
 
 #include "Utilities.h"
+#include "FileSystem.h"
 
 #include "zerrors.h"
 
@@ -13,47 +14,90 @@
 #include <numeric>
 
 
-void Scene::startScene(bool forReload) {
+void Scene::setSource(const std::string& sceneFile, bool useFuthark) {
+    if ((sceneFile == this->sceneFile) && (useFuthark == this->useFuthark))
+        return;
+    release();
+    this->sceneFile = sceneFile;
+    this->useFuthark = useFuthark;
+}
+
+void Scene::setUseFuthark(bool useFuthark) {
+    this->useFuthark = useFuthark;
+    updateShownAnimations(); // AnimationPlayers switch clips, and keep their time.
+}
+
+void Scene::updateShownAnimations() {
+    shownAnimations.clear();
+    for (int i = 0; i < std::ssize(animations); ++i) {
+        auto& variant = futharkAnimations[i];
+        shownAnimations.push_back((useFuthark && (variant.getFrameCount() > 0)) ? &variant : &animations[i]);
+    }
+}
+
+void Scene::makeResident(int loadGroup) {
+    if (resident)
+        return;
+    load(sceneFile, useFuthark, loadGroup);
+    resident = true;
+}
+
+void Scene::release() {
+    if (!resident)
+        return;
+
+    std::vector<const ResourceEntry*> entries;
+    for (const auto& animation : animations)
+        animation.getResources(entries);
+    for (const auto& animation : futharkAnimations)
+        animation.getResources(entries);
+
+    // Atlas sprites (frames of animations) stay cached, only their handles go. Atlas space is freed only with whole pages,
+    // so evicting them wouldn't free anything, and the next prefetch would pack them into new space again.
+    // Full-screen images have textures of their own, and those are what is worth evicting.
+    std::erase_if(entries, [](const ResourceEntry* entry) { return entry->kind == ResourceKind::SPRITE; });
+
+    animations.clear();
+    futharkAnimations.clear();
+    shownAnimations.clear();
+    players.clear();
+    positions.clear();
+    delays.clear();
+    resident = false;
+
+    game.resourceCache.evictUnused(entries);
+}
+
+void Scene::startScene() {
+    ZASSERT(resident) << "Scene '" << sceneFile << "' is not resident.";
     game.menu.setMenuRectangle(menuRectangle);
     animTime = 0.0f;
-    if (!forReload) {
-        music.Seek(0);
-        music.Play();
-    }
+    players.assign(animations.size(), AnimationPlayer());
+    game.musicManager.play(music, musicVolume);
 }
 
 void Scene::endScene() {
-    music.Stop();
+    if (resident)
+        game.musicManager.stop(music);
 }
 
-void Scene::load(const std::string& sceneFile, bool useFuthark, bool reloadHack) {
+void Scene::load(const std::string& sceneFile, bool useFuthark, int loadGroup) {
     auto jsonText = loadTextFile(sceneFile);
 
     auto json = nlohmann::json::parse(jsonText);
 
     auto basePath = std::filesystem::path(sceneFile).parent_path();
 
-    if (reloadHack) // Make loading faster!
-    {
-        auto imagePath = json["animations"][0]["image"].get<std::string>();
-        auto imPath = (basePath / imagePath).string();
-        if (useFuthark) {
-            size_t start_pos = imPath.find(".png");
-            imPath.replace(start_pos, 0, "-vr");
-        }
-        animations[0].fromPicture(game.resourceCache, imPath);
-        return;
-    }
-
+    this->useFuthark = useFuthark;
     animations.clear();
+    futharkAnimations.clear();
     positions.clear();
     delays.clear();
 
 
     auto musicPath = json["music"].get<std::string>();
-    auto musicVolume = json["musicVolume"].get<float>();
-    music.Load((basePath / musicPath).string());
-    music.SetVolume(musicVolume);
+    musicVolume = json["musicVolume"].get<float>();
+    music = game.musicManager.get((basePath / musicPath).string()); // Music stays loaded when scene is released, it is small.
 
     sceneDelay = json["sceneDelay"].get<float>();
     menuRectangle = loadJsonRect(json["menuRectangle"]);
@@ -72,38 +116,43 @@ void Scene::load(const std::string& sceneFile, bool useFuthark, bool reloadHack)
             loop = animation["loop"].get<bool>();
         }
         if (animation.contains("image")) {
-            auto imagePath = animation["image"].get<std::string>();
+            // Images have text, so they come in both scripts. Futhark one is next to the Polish one, with "-vr" suffix.
+            auto imagePath = basePath / animation["image"].get<std::string>();
+            auto futharkPath = imagePath;
+            futharkPath.replace_filename(imagePath.stem().string() + "-vr" + imagePath.extension().string());
             animations.emplace_back();
-            auto imPath = (basePath / imagePath).string();
-            if (useFuthark) {
-                size_t start_pos = imPath.find(".png");
-                imPath.replace(start_pos, 0, "-vr");
-            }
-            animations.back().fromPicture(game.resourceCache, imPath);
+            futharkAnimations.emplace_back();
+            animations.back().fromPicture(game.resourceCache, imagePath.string(), 1.0f, useFuthark ? Game::scriptVariantLoadGroup : loadGroup);
+            futharkAnimations.back().fromPicture(game.resourceCache, futharkPath.string(), 1.0f, useFuthark ? loadGroup : Game::scriptVariantLoadGroup);
         }
         else {
             auto animationPath = animation["animation"].get<std::string>();
             animations.emplace_back();
-            animations.back().load(game.resourceCache, (basePath / animationPath).string());
+            futharkAnimations.emplace_back();
+            animations.back().load(game.resourceCache, game.soundService, (basePath / animationPath).string(), loadGroup);
             animations.back().loop = loop;
         }
     }
+
+    updateShownAnimations();
+    players.assign(animations.size(), AnimationPlayer());
 }
 
 void Scene::update() {
-    music.Update();
-
     animTime += game.window.GetFrameTime();
 
     for (int i = 0; i < std::ssize(animations); ++i) {
         auto delay = delays[i];
         if (animTime < delay)
             continue;
-        auto [origin, image, sound] = animations[i].spriteForTime(animTime - delay);
-        image.Draw(positions[i] - origin);
-        if (sound)
-            sound->Play();
+        auto& player = players[i];
+        player.play(*shownAnimations[i]);
+        player.seek(animTime - delay);
+        if (auto sound = player.takeSound(); sound != noSound)
+            game.soundService.play(sound);
+        game.drawSpriteOnScreen(positions[i] - player.getOrigin(), player.getSprite(), i); // Layer keeps elements in order.
     }
+    game.flushSprites();
 }
 
 bool Scene::areAnimationsFinished() const {
@@ -111,10 +160,10 @@ bool Scene::areAnimationsFinished() const {
         return false;
     }
 
-    for (int i = 0; i < std::ssize(animations); ++i) {
-        if (animTime < animations[i].getAnimationLength())
+    for (int i = 0; i < std::ssize(shownAnimations); ++i) {
+        if (animTime < shownAnimations[i]->getAnimationLength())
             return false;
     }
 
     return true;
-}
\ No newline at end of file
+}
\ No newline at end of file
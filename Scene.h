@@ -4,20 +4,30 @@
 
 #include "raylib-cpp.hpp"
 
+#include <string>
 #include <tuple>
 #include <vector>
 
 class Game;
 
+/// Full-screen scene shown in one of the GameStates.
+/// Scenes are big, so they are resident (loaded) only around the time they are shown. See Game::updateSceneResidency().
 class Scene
 {
 private:
     Game& game;
+    std::string sceneFile;
+    bool useFuthark = false;
+    bool resident = false;
 
 public:
-    raylib::Music music;
+    ResourceId music = invalidResourceId;  ///< In Game::musicManager.
+    float musicVolume = 1.0f;
 
-    std::vector<Animation> animations;
+    std::vector<AnimationClip> animations;          ///< Animations in Polish script (or without any script).
+    std::vector<AnimationClip> futharkAnimations;   ///< Futhark variant of every animation. Empty (no frames) if animation has no text.
+    std::vector<const AnimationClip*> shownAnimations;  ///< Variant of every animation in the current script.
+    std::vector<AnimationPlayer> players;   ///< Player for every animation.
     std::vector<raylib::Vector2> positions;
     std::vector<float> delays;
 
@@ -29,10 +39,32 @@ public:
 public:
     Scene(Game& game) : game(game) {}
 
-    void startScene(bool forReload = false);
+    /// Sets scene file. It is loaded only when scene is made resident.
+    void setSource(const std::string& sceneFile, bool useFuthark);
+
+    /// Switches script of the images. Both variants are loaded with the scene, so this doesn't load anything.
+    void setUseFuthark(bool useFuthark);
+
+    /// Loads the scene, if it isn't loaded yet.
+    /// @param loadGroup    ResourceCache load group, to load asynchronously.
+    void makeResident(int loadGroup);
+
+    /// Unloads the scene, and evicts its images and sounds from ResourceCache (unless something else uses them).
+    /// Frames of its animations stay cached in the atlas, so making the scene resident again doesn't pack them again.
+    void release();
+
+    bool isResident() const { return resident; }
+    const std::string& getSceneFile() const { return sceneFile; }
+
+    void startScene();
     void endScene();
 
     bool areAnimationsFinished() const;
     void update();
-    void load(const std::string& sceneFile, bool useFuthark, bool reloadHack);
+    /// @param loadGroup    ResourceCache load group, to load images and animations asynchronously.
+    ///                     Images in the other script always load asynchronously, in Game::scriptVariantLoadGroup.
+    void load(const std::string& sceneFile, bool useFuthark, int loadGroup = ResourceCache::loadNow);
+
+private:
+    void updateShownAnimations();
 };
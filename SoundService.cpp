@@ -0,0 +1,111 @@
+#include "SoundService.h"
+
+#include "zerrors.h"
+
+
+SoundService::~SoundService() {
+    // Aliases must go before the sounds they share data with.
+    for (auto& voice : voices) {
+        if (voice.sound >= 0)
+            UnloadSoundAlias(voice.alias);
+    }
+}
+
+SoundId SoundService::load(const std::string& fileName, const SoundSettings& settings) {
+    ZASSERT(settings.maxVoices > 0) << "Sound '" << fileName << "' needs at least one voice.";
+
+    auto id = resourceCache.internPath(fileName);
+    for (int i = 0; i < std::ssize(sounds); ++i) {
+        if (sounds[i].id == id)
+            return i;
+    }
+
+    auto& slot = sounds.emplace_back();
+    slot.id = id;
+    slot.sound = resourceCache.getSound(id, slot.handle);
+    slot.settings = settings;
+    return static_cast<SoundId>(std::ssize(sounds) - 1);
+}
+
+bool SoundService::play(SoundId sound, std::optional<raylib::Vector2> position) {
+    ZASSERT((sound >= 0) && (sound < std::ssize(sounds))) << "Invalid sound id: " << sound;
+    const auto& settings = sounds[sound].settings;
+
+    if (position && (settings.maxDistance > 0.0f) && (listener.Distance(*position) > settings.maxDistance)) {
+        ++stats.culled;
+        return false;
+    }
+
+    // Pool is small, so a single pass finds everything we need.
+    Voice* freeVoice = nullptr;
+    Voice* oldestSame = nullptr;    ///< Oldest instance of the same sound.
+    Voice* victim = nullptr;        ///< Lowest priority (then oldest) voice this sound may take.
+    int sameCount = 0;
+    for (auto& voice : voices) {
+        if (!isActive(voice)) {
+            if (!freeVoice)
+                freeVoice = &voice;
+            continue;
+        }
+        if (voice.sound == sound) {
+            ++sameCount;
+            if (!oldestSame || (voice.startedAt < oldestSame->startedAt))
+                oldestSame = &voice;
+        }
+        if ((voice.priority <= settings.priority)
+            && (!victim || (voice.priority < victim->priority) || ((voice.priority == victim->priority) && (voice.startedAt < victim->startedAt))))
+            victim = &voice;
+    }
+
+    if (sameCount >= settings.maxVoices) {
+        ++stats.limited;
+        start(*oldestSame, sound);
+    }
+    else if (freeVoice) {
+        start(*freeVoice, sound);
+    }
+    else if (victim) {
+        ++stats.stolen;
+        start(*victim, sound);
+    }
+    else {
+        ++stats.dropped;
+        return false;
+    }
+    return true;
+}
+
+void SoundService::start(Voice& voice, SoundId sound) {
+    const auto& slot = sounds[sound];
+    if (voice.sound != sound) {
+        if (voice.sound >= 0)
+            UnloadSoundAlias(voice.alias);
+        voice.alias = LoadSoundAlias(*slot.sound);
+        voice.sound = sound;
+    }
+    else {
+        StopSound(voice.alias);
+    }
+
+    voice.priority = slot.settings.priority;
+    voice.startedAt = ++playCounter;
+    SetSoundVolume(voice.alias, slot.settings.volume);
+    PlaySound(voice.alias);
+    ++stats.played;
+}
+
+void SoundService::stopAll() {
+    for (auto& voice : voices) {
+        if (voice.sound >= 0)
+            StopSound(voice.alias);
+    }
+}
+
+int SoundService::getActiveVoiceCount() const {
+    int count = 0;
+    for (const auto& voice : voices) {
+        if (isActive(voice))
+            ++count;
+    }
+    return count;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ResourceCache.h"
+
+#include "raylib-cpp.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+/// How a sound effect is played.
+struct SoundSettings {
+    int maxVoices = 2;          ///< How many instances of the sound can play at once. Over the limit the oldest one is restarted.
+    int priority = 0;           ///< When all voices are busy, sound can take a voice playing a sound with lower (or equal) priority.
+    float volume = 1.0f;
+    float maxDistance = 0.0f;   ///< Sounds further than this from the listener are not played (in world units). Zero to always play.
+};
+
+struct SoundStats {
+    int played = 0;             ///< Sounds started.
+    int limited = 0;            ///< Sounds that restarted an instance of the same sound, because of SoundSettings::maxVoices.
+    int stolen = 0;             ///< Sounds that took a voice of a lower priority sound.
+    int dropped = 0;            ///< Sounds not played, because all voices played higher priority sounds.
+    int culled = 0;             ///< Sounds not played, because they were too far from the listener.
+};
+
+using SoundId = int;
+constexpr SoundId noSound = -1;
+
+/// Plays sound effects through a fixed pool of voices, so a sound can play over itself, and the mixer never has too many.
+/// Voices are aliases of sounds loaded through ResourceCache, so sample data is loaded only once.
+class SoundService {
+public:
+    static constexpr int voiceCount = 16;
+
+private:
+    struct SoundSlot {
+        ResourceId id;
+        ResourceHandle handle;
+        raylib::Sound* sound;
+        SoundSettings settings;
+    };
+
+    struct Voice {
+        ::Sound alias = {};
+        SoundId sound = -1;         ///< Sound the alias was made for, or -1 if none.
+        int priority = 0;
+        uint64_t startedAt = 0;     ///< Value of playCounter when the voice was started.
+    };
+
+    ResourceCache& resourceCache;
+    std::vector<SoundSlot> sounds;
+    std::array<Voice, voiceCount> voices;
+    raylib::Vector2 listener = { 0.0f, 0.0f };
+    uint64_t playCounter = 0;
+    SoundStats stats;
+
+public:
+    explicit SoundService(ResourceCache& resourceCache) : resourceCache(resourceCache) {}
+    ~SoundService();
+
+    SoundService(const SoundService&) = delete;
+    SoundService& operator=(const SoundService&) = delete;
+
+    /// Loads sound through ResourceCache. Loading the same file again returns the same id, and keeps the first settings.
+    SoundId load(const std::string& fileName, const SoundSettings& settings = {});
+
+    /// Plays a sound. Position (in world coordinates) is used for distance culling, sounds without one always play.
+    /// @returns True if the sound was played.
+    bool play(SoundId sound, std::optional<raylib::Vector2> position = std::nullopt);
+
+    /// Sets position (in world coordinates) sounds are heard from.
+    void setListener(raylib::Vector2 position) { listener = position; }
+
+    void stopAll();
+
+    int getActiveVoiceCount() const;
+    const SoundStats& getStats() const { return stats; }
+
+private:
+    bool isActive(const Voice& voice) const { return (voice.sound >= 0) && IsSoundPlaying(voice.alias); }
+    void start(Voice& voice, SoundId sound);
+};
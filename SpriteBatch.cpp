@@ -0,0 +1,93 @@
+#include "SpriteBatch.h"
+
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+
+void SpriteBatch::beginFrame() {
+    commands.clear();
+    lastTextureId = 0;
+    spriteCount = 0;
+    batchCount = 0;
+    textureSwitches = 0;
+}
+
+void SpriteBatch::add(const Sprite& sprite, raylib::Rectangle destination, bool horizontalMirror, int layer) {
+    if (sprite.source.width <= 0.0f)
+        return;
+
+    auto source = sprite.source;
+    if (horizontalMirror)
+        source.width = -source.width;
+    addQuad(*sprite.texture, source, destination, WHITE, layer);
+}
+
+void SpriteBatch::addQuad(const ::Texture2D& texture, raylib::Rectangle source, raylib::Rectangle destination, ::Color tint, int layer) {
+    commands.push_back(Command{ layer, texture.id, static_cast<uint32_t>(commands.size()), texture, source, destination, tint });
+}
+
+void SpriteBatch::flush() {
+    std::sort(commands.begin(), commands.end(), [](const Command& a, const Command& b) {
+        return std::tie(a.layer, a.textureId, a.order) < std::tie(b.layer, b.textureId, b.order);
+    });
+
+    for (size_t runStart = 0; runStart < commands.size(); ) {
+        const auto& texture = commands[runStart].texture;
+        auto runEnd = runStart;
+        while ((runEnd < commands.size()) && (commands[runEnd].layer == commands[runStart].layer) && (commands[runEnd].textureId == texture.id))
+            ++runEnd;
+
+        ++batchCount;
+        if (texture.id != lastTextureId) {
+            ++textureSwitches;
+            lastTextureId = texture.id;
+        }
+
+        auto width = static_cast<float>(texture.width);
+        auto height = static_cast<float>(texture.height);
+        for (auto chunkStart = runStart; chunkStart < runEnd; chunkStart += maxQuadsPerDraw) {
+            auto chunkEnd = std::min(chunkStart + maxQuadsPerDraw, runEnd);
+
+            // Same quads as DrawTexturePro() without rotation, but one rlBegin() for the whole chunk.
+            rlCheckRenderBatchLimit(4 * static_cast<int>(chunkEnd - chunkStart));
+            rlSetTexture(texture.id);
+            rlBegin(RL_QUADS);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+
+            for (auto i = chunkStart; i < chunkEnd; ++i) {
+                const auto& source = commands[i].source;
+                const auto& destination = commands[i].destination;
+                const auto& tint = commands[i].tint;
+                rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+
+                auto u0 = source.x / width;
+                auto u1 = (source.x + std::abs(source.width)) / width;
+                if (source.width < 0.0f)
+                    std::swap(u0, u1);
+                auto v0 = source.y / height;
+                auto v1 = (source.y + source.height) / height;
+
+                rlTexCoord2f(u0, v0);
+                rlVertex2f(destination.x, destination.y);
+                rlTexCoord2f(u0, v1);
+                rlVertex2f(destination.x, destination.y + destination.height);
+                rlTexCoord2f(u1, v1);
+                rlVertex2f(destination.x + destination.width, destination.y + destination.height);
+                rlTexCoord2f(u1, v0);
+                rlVertex2f(destination.x + destination.width, destination.y);
+            }
+
+            rlEnd();
+            rlSetTexture(0);
+        }
+
+        spriteCount += static_cast<int>(runEnd - runStart);
+        runStart = runEnd;
+    }
+
+    commands.clear();
+}
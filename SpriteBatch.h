@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ResourceCache.h"
+
+#include "raylib-cpp.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+/// Draw order of sprites within a batch. Lower layers are drawn first.
+enum class SpriteLayer : int {
+    PROPS,          ///< Exit door, speech bubbles.
+    COLLECTIBLES,
+    PLAYER,
+    HUD,
+};
+
+/// Records sprite draws during a frame and sends them to raylib sorted by layer, then by texture,
+/// so sprites sharing a texture end up in the same batch.
+/// Order of sprites on the same layer and texture is kept.
+class SpriteBatch {
+private:
+    static constexpr int maxQuadsPerDraw = 512;    ///< Stays well below raylib's batch size, so it never flushes in the middle of our quads.
+
+    struct Command {
+        int layer;
+        unsigned int textureId;
+        uint32_t order;                 ///< Index of the command in the frame. Keeps the sort stable.
+        ::Texture2D texture;
+        raylib::Rectangle source;       ///< Negative width to flip horizontally.
+        raylib::Rectangle destination;  ///< Screen coordinates.
+        ::Color tint;
+    };
+
+    std::vector<Command> commands;
+    unsigned int lastTextureId = 0;
+
+public:
+    int spriteCount = 0;        ///< Sprites drawn since beginFrame().
+    int batchCount = 0;         ///< Runs of quads sharing a texture, since beginFrame().
+    int textureSwitches = 0;    ///< Times the texture changed between consecutive runs, since beginFrame().
+
+public:
+    void beginFrame();
+
+    /// Records a sprite. Nothing is drawn until flush().
+    void add(const Sprite& sprite, raylib::Rectangle destination, bool horizontalMirror, int layer);
+
+    /// Records a part of any texture (font glyph, for example). Nothing is drawn until flush().
+    void addQuad(const ::Texture2D& texture, raylib::Rectangle source, raylib::Rectangle destination, ::Color tint, int layer);
+
+    /// Draws all recorded sprites. Call it before drawing anything that has to be on top of them.
+    void flush();
+};
@@ -0,0 +1,68 @@
+#include "StaticLayerCache.h"
+
+#include "zstr.h"
+
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+void StaticLayerCache::build(const std::vector<raylib::Texture2D>& layers, int levelWidth, int levelHeight) {
+    clear();
+    if (layers.empty())
+        return;
+
+    columns = (levelWidth + tileSize - 1) / tileSize;
+    rows = (levelHeight + tileSize - 1) / tileSize;
+    tiles.reserve(columns * rows);
+
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            auto width = std::min(tileSize, levelWidth - column * tileSize);
+            auto height = std::min(tileSize, levelHeight - row * tileSize);
+            tiles.emplace_back(width, height);
+
+            auto& tile = tiles.back();
+            tile.BeginMode();
+            ClearBackground(BLANK);
+            // Color is blended as usual, which premultiplies it. Alpha must accumulate, instead of being blended too.
+            rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+            BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+            for (const auto& layer : layers) {
+                raylib::Vector2 position{ static_cast<float>(-column * tileSize), static_cast<float>(-row * tileSize) };
+                layer.Draw(position);
+            }
+            EndBlendMode();
+            tile.EndMode();
+        }
+    }
+
+    TraceLog(LOG_INFO, (ZSTR() << "Static layer cache: " << layers.size() << " layers in " << columns << "x" << rows << " tiles").str().c_str());
+}
+
+void StaticLayerCache::clear() {
+    tiles.clear();
+    columns = 0;
+    rows = 0;
+}
+
+int StaticLayerCache::draw(raylib::Vector2 screenOrigin, raylib::Rectangle cameraView) const {
+    auto firstColumn = std::max(0, static_cast<int>(std::floor(cameraView.x / tileSize)));
+    auto firstRow = std::max(0, static_cast<int>(std::floor(cameraView.y / tileSize)));
+    auto lastColumn = std::min(columns - 1, static_cast<int>(std::floor((cameraView.x + cameraView.width) / tileSize)));
+    auto lastRow = std::min(rows - 1, static_cast<int>(std::floor((cameraView.y + cameraView.height) / tileSize)));
+
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY); // Tiles are premultiplied.
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const auto& texture = tiles[row * columns + column].texture;
+            raylib::Vector2 position = screenOrigin + raylib::Vector2{ static_cast<float>(column * tileSize), static_cast<float>(row * tileSize) };
+            // Render textures are upside down.
+            DrawTextureRec(texture, raylib::Rectangle{ 0.0f, 0.0f, static_cast<float>(texture.width), static_cast<float>(-texture.height) }, position, WHITE);
+        }
+    }
+    EndBlendMode();
+
+    return std::max(0, lastRow - firstRow + 1) * std::max(0, lastColumn - firstColumn + 1);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "raylib-cpp.hpp"
+
+#include <vector>
+
+
+/// Images that don't change during a level, composited once into render textures.
+/// Level is split into square tiles, so big levels don't need textures bigger than the GPU allows,
+/// and only tiles that are on screen are drawn.
+class StaticLayerCache {
+public:
+    static constexpr int tileSize = 1024;  ///< Width and height of a tile (in pixels).
+
+private:
+    std::vector<raylib::RenderTexture2D> tiles;    ///< Row by row.
+    int columns = 0;
+    int rows = 0;
+
+public:
+    /// Composites layers (in order) into tiles. Layers are placed at the level origin.
+    /// Tiles store premultiplied alpha, so partially transparent pixels look the same as when layers are drawn directly.
+    /// @note Uses render textures, so it must not be called between BeginDrawing() and EndDrawing().
+    void build(const std::vector<raylib::Texture2D>& layers, int levelWidth, int levelHeight);
+    void clear();
+
+    bool isEmpty() const { return tiles.empty(); }
+    int getTileCount() const { return static_cast<int>(std::ssize(tiles)); }
+
+    /// Draws tiles that overlap cameraView (in world coordinates).
+    /// @param screenOrigin     Screen position of the level origin.
+    /// @returns Number of tiles drawn.
+    int draw(raylib::Vector2 screenOrigin, raylib::Rectangle cameraView) const;
+};
@@ -0,0 +1,44 @@
+#include "TextCache.h"
+
+#include "Utilities.h"
+
+#include <functional>
+
+
+size_t TextCache::KeyHash::operator()(const KeyView& key) const {
+    auto hash = std::hash<std::u32string_view>()(key.text);
+    auto combine = [&](size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    combine(std::hash<const void*>()(key.font));
+    combine(std::hash<float>()(key.fontSize));
+    combine(std::hash<float>()(key.spacing));
+    combine((key.allowLowercase ? 1 : 0) + (key.allowDiacritics ? 2 : 0));
+    return hash;
+}
+
+bool TextCache::KeyEqual::operator()(const KeyView& a, const KeyView& b) const {
+    return (a.text == b.text) && (a.font == b.font) && (a.fontSize == b.fontSize) && (a.spacing == b.spacing)
+        && (a.allowLowercase == b.allowLowercase) && (a.allowDiacritics == b.allowDiacritics);
+}
+
+TextCache::Entry& TextCache::getEntry(const KeyView& key) {
+    auto it = entries.find(key);
+    if (it != entries.end())
+        return it->second;
+
+    ++conversions;
+    Entry entry;
+    entry.text = textForFont(key.allowLowercase, key.allowDiacritics, key.text);
+    if (key.font)
+        entry.glyphRun.layout(*key.font, entry.text, key.fontSize, key.spacing);
+
+    auto [newIt, inserted] = entries.try_emplace(Key{ std::u32string(key.text), key.font, key.fontSize, key.spacing, key.allowLowercase, key.allowDiacritics }, std::move(entry));
+    return newIt->second;
+}
+
+const std::string& TextCache::getText(std::u32string_view text, bool allowLowercase, bool allowDiacritics) {
+    return getEntry(KeyView{ text, nullptr, 0.0f, 0.0f, allowLowercase, allowDiacritics }).text;
+}
+
+const GlyphRun& TextCache::getGlyphRun(const ::Font& font, float fontSize, float spacing, std::u32string_view text, bool allowLowercase, bool allowDiacritics) {
+    return getEntry(KeyView{ text, &font, fontSize, spacing, allowLowercase, allowDiacritics }).glyphRun;
+}
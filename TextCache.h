@@ -0,0 +1,73 @@
+#pragma once
+
+#include "GlyphRun.h"
+
+#include "raylib-cpp.hpp"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+/// Caches textForFont() conversions, and glyph runs laid out from them.
+/// Entries are keyed by text, font and flags, so a lookup of cached text doesn't allocate or convert anything.
+class TextCache {
+private:
+    struct KeyView {
+        std::u32string_view text;
+        const ::Font* font;             ///< Nullptr for entries with converted text only.
+        float fontSize;
+        float spacing;
+        bool allowLowercase;
+        bool allowDiacritics;
+    };
+
+    struct Key {
+        std::u32string text;
+        const ::Font* font;
+        float fontSize;
+        float spacing;
+        bool allowLowercase;
+        bool allowDiacritics;
+
+        KeyView view() const { return { text, font, fontSize, spacing, allowLowercase, allowDiacritics }; }
+    };
+
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(const KeyView& key) const;
+        size_t operator()(const Key& key) const { return (*this)(key.view()); }
+    };
+
+    struct KeyEqual {
+        using is_transparent = void;
+        bool operator()(const KeyView& a, const KeyView& b) const;
+        bool operator()(const Key& a, const KeyView& b) const { return (*this)(a.view(), b); }
+        bool operator()(const KeyView& a, const Key& b) const { return (*this)(a, b.view()); }
+        bool operator()(const Key& a, const Key& b) const { return (*this)(a.view(), b.view()); }
+    };
+
+    struct Entry {
+        std::string text;   ///< Result of textForFont().
+        GlyphRun glyphRun;  ///< Empty for entries without a font.
+    };
+
+    std::unordered_map<Key, Entry, KeyHash, KeyEqual> entries;
+    int conversions = 0;
+
+public:
+    /// @returns textForFont(allowLowercase, allowDiacritics, text). Converted only the first time.
+    const std::string& getText(std::u32string_view text, bool allowLowercase, bool allowDiacritics);
+
+    /// @returns textForFont(allowLowercase, allowDiacritics, text) laid out with given font. Laid out only the first time.
+    const GlyphRun& getGlyphRun(const ::Font& font, float fontSize, float spacing, std::u32string_view text, bool allowLowercase, bool allowDiacritics);
+
+    /// Removes all entries. Call when texts won't be used any more (after language change, for example).
+    void clear() { entries.clear(); }
+
+    int getEntryCount() const { return static_cast<int>(std::ssize(entries)); }
+    int getConversionCount() const { return conversions; }     ///< Number of conversions (cache misses) since start.
+
+private:
+    Entry& getEntry(const KeyView& key);
+};
@@ -0,0 +1,139 @@
+// Converts PNG images in Runtime/ to QOI, which decodes several times faster. Game loads converted files when they exist.
+// Usage: AssetConverter <runtime directory> [--benchmark]
+// With --benchmark also compares decode times and sizes of both formats, for every asset class.
+
+#include "raylib.h"
+
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+/// Directories converted, and asset class of every one of them.
+const std::vector<std::pair<std::string, std::string>> assetClasses = {
+    { "Graphics", "sprites" },
+    { "Levels", "layers" },
+    { "Scenes", "scenes" },
+};
+
+const std::string skippedDirectory = "Graphics/Fonts"; // Fonts are loaded by raylib's font loader, which wants PNGs.
+
+struct ClassStats {
+    int files = 0;
+    uint64_t pngBytes = 0;
+    uint64_t qoiBytes = 0;
+    double pngDecodeTime = 0.0;
+    double qoiDecodeTime = 0.0;
+};
+
+std::vector<unsigned char> readFile(const std::filesystem::path& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+        throw std::runtime_error("Could not open '" + path.string() + "'.");
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
+
+/// @returns How long decoding from memory took (in seconds). File reading isn't included.
+double decodeTime(const std::vector<unsigned char>& data, const char* fileType) {
+    auto startTime = std::chrono::steady_clock::now();
+    auto image = LoadImageFromMemory(fileType, data.data(), static_cast<int>(data.size()));
+    auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    if (!image.data)
+        throw std::runtime_error(std::string("Could not decode ") + fileType + " image.");
+    UnloadImage(image);
+    return time;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    if ((argc < 2) || (argc > 3) || ((argc == 3) && (std::string(argv[2]) != "--benchmark"))) {
+        std::cerr << "Usage: " << argv[0] << " <runtime directory> [--benchmark]\n";
+        return 2;
+    }
+
+    try {
+        std::filesystem::path runtimeDir = argv[1];
+        bool benchmark = (argc == 3);
+        SetTraceLogLevel(LOG_WARNING);
+
+        std::map<std::string, ClassStats> stats;
+        int converted = 0;
+        int upToDate = 0;
+
+        for (const auto& [directory, assetClass] : assetClasses) {
+            if (!std::filesystem::exists(runtimeDir / directory))
+                continue;
+
+            for (const auto& item : std::filesystem::recursive_directory_iterator(runtimeDir / directory)) {
+                if (!item.is_regular_file() || (item.path().extension() != ".png"))
+                    continue;
+                auto relative = std::filesystem::relative(item.path(), runtimeDir).generic_string();
+                if (relative.starts_with(skippedDirectory))
+                    continue;
+
+                auto sourcePath = item.path();
+                auto convertedPath = std::filesystem::path(sourcePath).replace_extension(".qoi");
+
+                if (std::filesystem::exists(convertedPath) && (std::filesystem::last_write_time(convertedPath) >= std::filesystem::last_write_time(sourcePath))) {
+                    ++upToDate;
+                }
+                else {
+                    auto image = LoadImage(sourcePath.string().c_str());
+                    if (!image.data)
+                        throw std::runtime_error("Could not load '" + sourcePath.string() + "'.");
+                    // QOI stores 8 bit RGB(A) only.
+                    if ((image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) && (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8))
+                        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+                    auto exported = ExportImage(image, convertedPath.string().c_str());
+                    UnloadImage(image);
+                    if (!exported)
+                        throw std::runtime_error("Could not write '" + convertedPath.string() + "'.");
+                    ++converted;
+                }
+
+                if (benchmark) {
+                    auto png = readFile(sourcePath);
+                    auto qoi = readFile(convertedPath);
+                    auto& classStats = stats[assetClass];
+                    ++classStats.files;
+                    classStats.pngBytes += png.size();
+                    classStats.qoiBytes += qoi.size();
+                    classStats.pngDecodeTime += decodeTime(png, ".png");
+                    classStats.qoiDecodeTime += decodeTime(qoi, ".qoi");
+                }
+            }
+        }
+
+        std::cout << "Converted " << converted << " images, " << upToDate << " were up to date.\n";
+
+        if (benchmark) {
+            std::cout << std::fixed << std::setprecision(1);
+            std::cout << "class      files    PNG KB    QOI KB    PNG decode ms    QOI decode ms\n";
+            for (const auto& [assetClass, classStats] : stats) {
+                std::cout << std::left << std::setw(10) << assetClass << std::right
+                    << std::setw(6) << classStats.files
+                    << std::setw(10) << classStats.pngBytes / 1024
+                    << std::setw(10) << classStats.qoiBytes / 1024
+                    << std::setw(17) << classStats.pngDecodeTime * 1000.0
+                    << std::setw(17) << classStats.qoiDecodeTime * 1000.0 << "\n";
+            }
+        }
+    }
+    catch (const std::exception& exc) {
+        std::cerr << "Error: " << exc.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
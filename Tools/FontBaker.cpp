@@ -0,0 +1,117 @@
+// Bakes glyph atlases of a font, so the game doesn't have to rasterize it on every start. See BakedFont.h.
+// Usage: FontBaker <font file> <charset file> <size>[,<size>...] [--sdf]
+// With --sdf atlases store signed distance fields, which stay crisp when drawn at other sizes (with an SDF shader).
+
+#include "raylib.h"
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+constexpr int defaultPadding = 4;   ///< Same as raylib's LoadFontEx() uses.
+
+std::vector<int> parseSizes(const std::string& text) {
+    std::vector<int> sizes;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        auto size = std::stoi(item);
+        if (size <= 0)
+            throw std::runtime_error("Invalid font size: " + item);
+        sizes.push_back(size);
+    }
+    return sizes;
+}
+
+std::vector<int> loadCharset(const std::filesystem::path& charsetFile) {
+    char* text = LoadFileText(charsetFile.string().c_str());
+    if (!text)
+        throw std::runtime_error("Could not open '" + charsetFile.string() + "'.");
+    int codepointCount = 0;
+    int* codepoints = LoadCodepoints(text, &codepointCount);
+    std::vector<int> charset(codepoints, codepoints + codepointCount);
+    UnloadFileText(text);
+    UnloadCodepoints(codepoints);
+    return charset;
+}
+
+/// Writes atlas and metrics of the font at given size. @returns Number of glyphs.
+int bake(const std::filesystem::path& fontFile, const std::vector<unsigned char>& fontData, std::vector<int>& charset, int fontSize, bool sdf) {
+    auto fontType = sdf ? FONT_SDF : FONT_DEFAULT;
+    auto glyphs = LoadFontData(fontData.data(), static_cast<int>(fontData.size()), fontSize, charset.data(), static_cast<int>(charset.size()), fontType);
+    if (!glyphs)
+        throw std::runtime_error("Could not rasterize '" + fontFile.string() + "'.");
+
+    // Same packing as raylib's examples use for both kinds of fonts.
+    auto padding = sdf ? 0 : defaultPadding;
+    Rectangle* recs = nullptr;
+    auto atlas = GenImageFontAtlas(glyphs, &recs, static_cast<int>(charset.size()), fontSize, padding, sdf ? 1 : 0);
+
+    // Font names can have dots, so extensions are appended, not replaced.
+    auto bakedName = (fontFile.parent_path() / (fontFile.stem().string() + "-" + std::to_string(fontSize) + (sdf ? "-sdf" : ""))).string();
+
+    auto exported = ExportImage(atlas, (bakedName + ".png").c_str());
+
+    std::ofstream metrics(bakedName + ".json", std::ios::binary);
+    metrics << "{\n    \"font\": \"" << fontFile.filename().string() << "\",\n    \"size\": " << fontSize << ",\n    \"padding\": " << padding
+            << ",\n    \"sdf\": " << (sdf ? "true" : "false") << ",\n    \"glyphs\": [\n";
+    for (int i = 0; i < static_cast<int>(charset.size()); ++i) {
+        const auto& glyph = glyphs[i];
+        const auto& rec = recs[i];
+        metrics << "        [" << glyph.value << ", " << rec.x << ", " << rec.y << ", " << rec.width << ", " << rec.height << ", "
+                << glyph.offsetX << ", " << glyph.offsetY << ", " << glyph.advanceX << "]" << ((i + 1 < static_cast<int>(charset.size())) ? ",\n" : "\n");
+    }
+    metrics << "    ]\n}\n";
+
+    UnloadImage(atlas);
+    MemFree(recs);
+    UnloadFontData(glyphs, static_cast<int>(charset.size()));
+
+    if (!exported || !metrics)
+        throw std::runtime_error("Could not write '" + bakedName + "'.");
+    return static_cast<int>(charset.size());
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    if ((argc < 4) || (argc > 5) || ((argc == 5) && (std::string(argv[4]) != "--sdf"))) {
+        std::cerr << "Usage: " << argv[0] << " <font file> <charset file> <size>[,<size>...] [--sdf]\n";
+        return 2;
+    }
+
+    try {
+        std::filesystem::path fontFile = argv[1];
+        auto charset = loadCharset(argv[2]);
+        auto sizes = parseSizes(argv[3]);
+        bool sdf = (argc == 5);
+        SetTraceLogLevel(LOG_WARNING);
+
+        int dataSize = 0;
+        auto data = LoadFileData(fontFile.string().c_str(), &dataSize);
+        if (!data)
+            throw std::runtime_error("Could not open '" + fontFile.string() + "'.");
+        std::vector<unsigned char> fontData(data, data + dataSize);
+        UnloadFileData(data);
+
+        for (auto size : sizes) {
+            auto glyphCount = bake(fontFile, fontData, charset, size, sdf);
+            std::cout << "Baked " << fontFile.filename().string() << " at " << size << " px" << (sdf ? " (SDF)" : "") << ", " << glyphCount << " glyphs.\n";
+        }
+    }
+    catch (const std::exception& exc) {
+        std::cerr << "Error: " << exc.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+// Builds a resource pack from a directory (normally Runtime/).
+// Usage: PackTool <source directory> <output pack>
+// Fails if a converted image is older than its PNG, so run AssetConverter first (the build does).
+
+#include "../ResourcePack.h"
+#include "../PathInterner.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+struct SourceFile {
+    std::string name;                   ///< Normalized path relative to the source directory.
+    std::filesystem::path path;
+    std::vector<unsigned char> data;    ///< As stored in the pack.
+    uint32_t size = 0;
+    uint32_t flags = 0;
+};
+
+/// Text formats compress well. Images and audio are compressed already, and music has to be stored as is, because it is streamed.
+bool shouldCompress(const std::filesystem::path& path) {
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return (extension == ".json") || (extension == ".csv") || (extension == ".txt") || (extension == ".ldtk");
+}
+
+std::vector<unsigned char> readFile(const std::filesystem::path& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+        throw std::runtime_error("Could not open '" + path.string() + "'.");
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
+
+void pad(std::ofstream& output, uint64_t& offset) {
+    static const char zeros[packAlignment] = {};
+    auto padding = (packAlignment - offset % packAlignment) % packAlignment;
+    output.write(zeros, padding);
+    offset += padding;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <source directory> <output pack>\n";
+        return 2;
+    }
+
+    try {
+        std::filesystem::path sourceDir = argv[1];
+        std::filesystem::path packPath = argv[2];
+        SetTraceLogLevel(LOG_WARNING);
+
+        std::vector<SourceFile> files;
+        for (const auto& item : std::filesystem::recursive_directory_iterator(sourceDir)) {
+            if (!item.is_regular_file())
+                continue;
+            std::error_code error;
+            if (std::filesystem::equivalent(item.path(), packPath, error))
+                continue; // Pack may be built inside of the source directory.
+            if (item.path().extension() == ".png") {
+                auto convertedPath = std::filesystem::path(item.path()).replace_extension(".qoi");
+                if (std::filesystem::exists(convertedPath)) {
+                    // Game loads converted image instead (see AssetConverter.cpp). It can't tell if that is stale, so we have to.
+                    if (std::filesystem::last_write_time(convertedPath) < std::filesystem::last_write_time(item.path()))
+                        throw std::runtime_error("'" + convertedPath.string() + "' is older than its PNG. Run AssetConverter first.");
+                    continue;
+                }
+            }
+
+            SourceFile file;
+            file.path = item.path();
+            file.name = PathInterner::normalize(std::filesystem::relative(item.path(), sourceDir).generic_string());
+            file.data = readFile(item.path());
+            file.size = static_cast<uint32_t>(file.data.size());
+
+            if (shouldCompress(file.path) && !file.data.empty()) {
+                int compressedSize = 0;
+                auto compressed = CompressData(file.data.data(), static_cast<int>(file.data.size()), &compressedSize);
+                if (compressed && (compressedSize < static_cast<int>(file.data.size()) * 9 / 10)) {
+                    file.data.assign(compressed, compressed + compressedSize);
+                    file.flags |= PACK_ENTRY_COMPRESSED;
+                }
+                MemFree(compressed);
+            }
+            files.push_back(std::move(file));
+        }
+
+        std::sort(files.begin(), files.end(), [](const SourceFile& a, const SourceFile& b) { return a.name < b.name; });
+
+        std::ofstream output(packPath, std::ios::binary);
+        if (!output)
+            throw std::runtime_error("Could not create '" + packPath.string() + "'.");
+
+        PackHeader header;
+        header.entryCount = static_cast<uint32_t>(files.size());
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Rewritten at the end.
+        uint64_t offset = sizeof(header);
+
+        std::vector<PackEntry> entries;
+        std::string names;
+        uint64_t totalSize = 0;
+        uint64_t storedSize = 0;
+        for (const auto& file : files) {
+            pad(output, offset);
+            PackEntry entry = {};
+            entry.dataOffset = offset;
+            entry.storedSize = static_cast<uint32_t>(file.data.size());
+            entry.size = file.size;
+            entry.nameOffset = static_cast<uint32_t>(names.size());
+            entry.nameLength = static_cast<uint32_t>(file.name.size());
+            entry.flags = file.flags;
+            entries.push_back(entry);
+            names += file.name;
+
+            output.write(reinterpret_cast<const char*>(file.data.data()), file.data.size());
+            offset += file.data.size();
+            totalSize += file.size;
+            storedSize += file.data.size();
+        }
+
+        pad(output, offset);
+        header.indexOffset = offset;
+        output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackEntry));
+        offset += entries.size() * sizeof(PackEntry);
+        header.namesOffset = offset;
+        output.write(names.data(), names.size());
+
+        output.seekp(0);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!output)
+            throw std::runtime_error("Error while writing '" + packPath.string() + "'.");
+
+        std::cout << "Packed " << files.size() << " files: " << totalSize / 1024 << " KB, " << storedSize / 1024 << " KB stored.\n";
+    }
+    catch (const std::exception& exc) {
+        std::cerr << "Error: " << exc.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "UniformGrid.h"
+
+#include "zerrors.h"
+
+#include <cmath>
+
+
+void UniformGrid::resize(int worldWidth, int worldHeight, float cellSize) {
+    ZASSERT(cellSize > 0.0f);
+    this->cellSize = cellSize;
+    columns = std::max(1, static_cast<int>(std::ceil(worldWidth / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(worldHeight / cellSize)));
+    cellStart.assign(columns * rows + 1, 0);
+    cellItems.clear();
+    itemFirstCell.clear();
+}
+
+std::tuple<int, int, int, int> UniformGrid::cellRange(raylib::Rectangle area) const {
+    auto minColumn = std::clamp(static_cast<int>(std::floor(area.x / cellSize)), 0, columns - 1);
+    auto minRow = std::clamp(static_cast<int>(std::floor(area.y / cellSize)), 0, rows - 1);
+    auto maxColumn = std::clamp(static_cast<int>(std::floor((area.x + area.width) / cellSize)), 0, columns - 1);
+    auto maxRow = std::clamp(static_cast<int>(std::floor((area.y + area.height) / cellSize)), 0, rows - 1);
+    return { minColumn, minRow, maxColumn, maxRow };
+}
+
+void UniformGrid::build(const std::vector<raylib::Rectangle>& bounds) {
+    ZASSERT(columns > 0) << "UniformGrid::resize() must be called first.";
+
+    itemFirstCell.resize(bounds.size());
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+
+    // Count items per cell.
+    for (int item = 0; item < std::ssize(bounds); ++item) {
+        auto [minColumn, minRow, maxColumn, maxRow] = cellRange(bounds[item]);
+        itemFirstCell[item] = { minColumn, minRow };
+        for (int row = minRow; row <= maxRow; ++row)
+            for (int column = minColumn; column <= maxColumn; ++column)
+                cellStart[row * columns + column + 1]++;
+    }
+
+    for (int cell = 0; cell < columns * rows; ++cell)
+        cellStart[cell + 1] += cellStart[cell];
+
+    // Fill cells, using cellStart as insertion cursors, then shift it back.
+    cellItems.resize(cellStart.back());
+    for (int item = 0; item < std::ssize(bounds); ++item) {
+        auto [minColumn, minRow, maxColumn, maxRow] = cellRange(bounds[item]);
+        for (int row = minRow; row <= maxRow; ++row)
+            for (int column = minColumn; column <= maxColumn; ++column)
+                cellItems[cellStart[row * columns + column]++] = item;
+    }
+
+    for (int cell = columns * rows; cell > 0; --cell)
+        cellStart[cell] = cellStart[cell - 1];
+    cellStart[0] = 0;
+}
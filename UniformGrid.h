@@ -0,0 +1,56 @@
+#pragma once
+
+#include "raylib-cpp.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+
+/// Broadphase for axis aligned rectangles.
+/// World is split into square cells, and every item is stored in every cell it overlaps.
+/// Built from scratch with a counting sort, so it is cheap to rebuild every frame.
+class UniformGrid {
+private:
+    float cellSize = 128.0f;
+    int columns = 0;
+    int rows = 0;
+    std::vector<int> cellStart;                 ///< Items of cell i are cellItems[cellStart[i] .. cellStart[i + 1]).
+    std::vector<int> cellItems;                 ///< Item indices, grouped by cell.
+    std::vector<std::tuple<int, int>> itemFirstCell;   ///< Top-left cell (column, row) of every item.
+
+public:
+    /// Sets world size (in pixels) and cell size. Removes all items.
+    void resize(int worldWidth, int worldHeight, float cellSize);
+
+    /// Replaces all items. Item index is the index in bounds.
+    void build(const std::vector<raylib::Rectangle>& bounds);
+
+    /// Calls func(itemIndex) once for every item which cells overlap area.
+    /// @note Items are not tested against area, only their cells are.
+    template<typename Func>
+    void query(raylib::Rectangle area, Func&& func) const {
+        if (cellItems.empty())
+            return;
+
+        auto [minColumn, minRow, maxColumn, maxRow] = cellRange(area);
+        for (int row = minRow; row <= maxRow; ++row) {
+            for (int column = minColumn; column <= maxColumn; ++column) {
+                auto cell = row * columns + column;
+                for (int i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                    auto item = cellItems[i];
+                    // Item spanning many cells is reported only from the first cell shared with the area.
+                    auto [itemColumn, itemRow] = itemFirstCell[item];
+                    if ((std::max(itemColumn, minColumn) == column) && (std::max(itemRow, minRow) == row))
+                        func(item);
+                }
+            }
+        }
+    }
+
+    int getItemCount() const { return static_cast<int>(std::ssize(itemFirstCell)); }
+
+private:
+    /// @returns (minColumn, minRow, maxColumn, maxRow) of cells overlapping area, clamped to the grid.
+    std::tuple<int, int, int, int> cellRange(raylib::Rectangle area) const;
+};
@@ -26,12 +26,11 @@ std::tuple<int, float> divide(float value, float divisor);
 
 raylib::Rectangle loadJsonRect(const nlohmann::json& json);
 
-void DrawTextureTiled(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin = {0.0f, 0.0f}, float rotation = 0.0f, float scale = 1.0f, Color tint = WHITE);
-
 /// Converts u32 string into something that can be displayed using given font.
 /// @param allowLowercase   If false lower case characters are replaced with uppercase.
 /// @param allowDiacritics  If false diacritics are replaced with non-diacritic versions of characters.
-std::string textForFont(bool allowLowercase, bool allowDiacritics, const std::u32string& text);
+/// @note Converting is slow, use TextCache for text drawn every frame.
+std::string textForFont(bool allowLowercase, bool allowDiacritics, std::u32string_view text);
 
 /// Loads codepoints from a file.
 /// Throws if there are any duplicates.
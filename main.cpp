@@ -1,6 +1,7 @@
 ﻿#include "raylib-cpp.hpp"
 
 #include "Game.h"
+#include "FileSystem.h"
 
 #include "zerrors.h"
 
@@ -16,6 +17,7 @@ std::unique_ptr<Game> global_game;
 
 void updateDrawFrame() {
     if (!global_game) {
+        initFileSystem("Resources.pack");
         global_game.reset(new Game()); // We must initialize window after emscripten main loop is defined.
         global_game->restartGame();
     }
@@ -32,6 +34,7 @@ int main()
         emscripten_set_main_loop(updateDrawFrame, 0, 1);
 #else
         SetTargetFPS(60);   // Set our game to run at 60 frames-per-second
+        initFileSystem("Resources.pack");
         global_game.reset(new Game());
         global_game->restartGame();
         global_game->mainLoop();